@@ -36,19 +36,25 @@ __CONVERSION_AUTO_DEPS = [
     "@com_google_absl//absl/status:statusor",
     "@com_google_absl//absl/strings",
     "@com_google_absl//absl/time",
+    "@com_google_absl//absl/types:span",
+    "@com_google_cpp_proto_builder//proto_builder/oss:builder_policy_cc",
     "@com_google_cpp_proto_builder//proto_builder/oss:source_location_cc",
     "@com_google_cpp_proto_builder//proto_builder/oss:parse_text_proto_cc",
     "@com_google_cpp_proto_builder//proto_builder/oss:proto_conversion_helpers_cc",
+    "@com_google_cpp_proto_builder//proto_builder/oss:wire_writer_cc",
 ]
 
 # Headers used in conversions, must match 'proto_builder_config*.textproto'.
 _CONVERSION_HEADERS = [
+    "proto_builder/oss/builder_policy.h",
     "proto_builder/oss/parse_text_proto.h",
     "proto_builder/oss/source_location.h",
+    "proto_builder/oss/wire_writer.h",
     "absl/status/status.h",
     "absl/status/statusor.h",
     "absl/strings/string_view.h",
     "absl/time/time.h",
+    "absl/types/span.h",
     "google/protobuf/util/time_util.h",
 ]
 
@@ -239,3 +245,110 @@ text_proto_test = rule(
     implementation = _text_proto_test_impl,
     test = True,
 )
+
+def _text_proto_binary_impl(ctx):
+    """The implementation of the 'text_proto_binary' rule.
+
+    Args:
+      ctx: The current rule's context object.
+
+    Returns:
+      DefaultInfo provider
+    """
+    proto_files = []
+    for dep in ctx.attr.deps:
+        proto_files += dep[ProtoInfo].transitive_sources.to_list()
+    proto_paths = ",".join(
+        [_strip_from_external_for_proto(proto) for proto in proto_files],
+    )
+    direct_sources = []
+    for dep in ctx.attr.deps:
+        direct_sources += dep[ProtoInfo].direct_sources
+    src = ctx.file.src
+    header = ctx.outputs.out
+    ctx.actions.run(
+        executable = ctx.executable._parse_textproto_file_tool,
+        arguments = [
+            "--proto_type=" + ctx.attr.message,
+            "--textproto=" + src.path,
+            "--proto_paths=" + proto_paths,
+            "--binary_header=" + header.path,
+            "--binary_name=" + ctx.attr.variable,
+        ] + [file.path for file in direct_sources],
+        inputs = proto_files + [src],
+        outputs = [header],
+        mnemonic = "TextProtoBinary",
+        progress_message = "Serializing text proto %s" % src.short_path,
+    )
+    return [DefaultInfo(files = depset([header]))]
+
+_text_proto_binary = rule(
+    attrs = {
+        "src": attr.label(
+            doc = "The text proto file to serialize.",
+            allow_single_file = [".textproto"],
+            mandatory = True,
+        ),
+        "message": attr.string(
+            doc = "The name of the message type that \"src\" file represents.",
+            mandatory = True,
+        ),
+        "variable": attr.string(
+            doc = "The (optionally namespace qualified) name of the generated " +
+                  "`constexpr absl::string_view`.",
+            mandatory = True,
+        ),
+        "out": attr.output(
+            doc = "The generated header.",
+            mandatory = True,
+        ),
+        "deps": attr.label_list(
+            doc = "A list of proto_library targets where \"message\" is " +
+                  "defined. Transitive dependencies are pulled in " +
+                  "automatically.",
+            allow_rules = ["proto_library"],
+            providers = [ProtoInfo],
+        ),
+        "_parse_textproto_file_tool": attr.label(
+            doc = "The target of the parse textproto file executable.",
+            default = Label("@com_google_cpp_proto_builder//proto_builder/oss:parse_textproto_file"),
+            allow_single_file = True,
+            executable = True,
+            cfg = "exec",
+        ),
+    },
+    doc = "Serialize a text format protocol buffer into a C++ header.",
+    implementation = _text_proto_binary_impl,
+)
+
+def text_proto_binary_library(name, src, message, variable, deps, **kwargs):
+    """Compiles a text proto file into a header with its binary serialization.
+
+    The text is parsed at build time and the header `<name>.h` defines
+    `inline constexpr absl::string_view <variable>` which holds the serialized
+    message. That can be parsed at runtime with `ParseBinaryOrDie<T>` or the
+    `@BinaryProto` conversion, which avoids parsing text at runtime.
+
+    Args:
+      name: The name of the cc_library.
+      src: The text proto file.
+      message: The full name of the proto message type of `src`.
+      variable: The (optionally namespace qualified) name of the variable.
+      deps: The proto_library targets that define `message`.
+      **kwargs: Additional arguments for the cc_library.
+    """
+    _text_proto_binary(
+        name = name + "_gen",
+        src = src,
+        message = message,
+        variable = variable,
+        out = name + ".h",
+        deps = deps,
+        testonly = kwargs.get("testonly", False),
+    )
+    native.cc_library(
+        name = name,
+        hdrs = [name + ".h"],
+        deps = ["@com_google_absl//absl/strings"],
+        **kwargs
+    )
@@ -16,11 +16,14 @@
 
 #include "proto_builder/builder_writer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
 
 #include "proto_builder/oss/file.h"
 #include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/trace.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
@@ -142,9 +145,13 @@ void BufferWriter::Write(Where to, const std::string& line) {
   buffer_[to].push_back(line);
 }
 
-absl::Status BufferWriter::WriteFile(Where from,
-                                     const std::string& filename) const {
-  return file::oss::SetContents(filename, absl::StrJoin(From(from), "\n"));
+absl::Status BufferWriter::WriteFile(Where from, const std::string& filename,
+                                     const file::oss::Options& options) const {
+  oss::TraceScope trace("WriteFile");
+  trace.AddArg("file", filename);
+  trace.AddArg("lines", From(from).size());
+  return file::oss::SetContents(filename, absl::StrJoin(From(from), "\n"),
+                                options);
 }
 
 void BufferWriter::MoveContents(Where from, BufferWriter* to_writer) {
@@ -157,6 +164,71 @@ void BufferWriter::MoveContents(Where from, BufferWriter* to_writer) {
 CodeInfoCollector* BufferWriter::CodeInfo() { return &code_info_; }
 const CodeInfoCollector* BufferWriter::CodeInfo() const { return &code_info_; }
 
+ChunkedBufferWriter::ChunkedBufferWriter(
+    const std::vector<std::string>& package_path)
+    : code_info_(package_path) {
+  for (Where where : {HEADER, SOURCE, INTERFACE}) {
+    buffer_.try_emplace(where);  // Target is move-only.
+  }
+}
+
+void ChunkedBufferWriter::Write(Where to, const std::string& line) {
+  Target& target = buffer_[to];
+  const size_t needed = line.size() + 1;  // Including the new-line.
+  if (target.chunks.empty() ||
+      target.chunks.back().capacity - target.chunks.back().size < needed) {
+    const size_t capacity = std::max(kChunkSize, needed);
+    target.chunks.push_back({absl::make_unique<char[]>(capacity), 0, capacity});
+  }
+  Chunk& chunk = target.chunks.back();
+  char* const start = chunk.data.get() + chunk.size;
+  std::memcpy(start, line.data(), line.size());
+  start[line.size()] = '\n';
+  chunk.size += needed;
+  target.lines.emplace_back(start, line.size());
+}
+
+std::vector<absl::string_view> ChunkedBufferWriter::Pieces(Where from) const {
+  const Target& target = buffer_.at(from);
+  std::vector<absl::string_view> pieces;
+  pieces.reserve(target.chunks.size());
+  for (const Chunk& chunk : target.chunks) {
+    pieces.emplace_back(chunk.data.get(), chunk.size);
+  }
+  if (!pieces.empty()) {
+    pieces.back().remove_suffix(1);  // Lines are joined, not terminated.
+  }
+  return pieces;
+}
+
+std::string ChunkedBufferWriter::Contents(Where from) const {
+  const std::vector<absl::string_view> pieces = Pieces(from);
+  size_t size = 0;
+  for (absl::string_view piece : pieces) {
+    size += piece.size();
+  }
+  std::string result;
+  result.reserve(size);
+  for (absl::string_view piece : pieces) {
+    result.append(piece.data(), piece.size());
+  }
+  return result;
+}
+
+absl::Status ChunkedBufferWriter::WriteFile(
+    Where from, const std::string& filename,
+    const file::oss::Options& options) const {
+  oss::TraceScope trace("WriteFile");
+  trace.AddArg("file", filename);
+  trace.AddArg("lines", Lines(from).size());
+  return file::oss::SetContents(filename, Pieces(from), options);
+}
+
+CodeInfoCollector* ChunkedBufferWriter::CodeInfo() { return &code_info_; }
+const CodeInfoCollector* ChunkedBufferWriter::CodeInfo() const {
+  return &code_info_;
+}
+
 void NoDoubleEmptyLineWriter::Write(Where to, const std::string& line) {
   // Do not start with an empty line or write two consecutive empty lines.
   // We store the negation into the map. That means upon the first line, the
@@ -24,11 +24,13 @@
 #include <utility>
 #include <vector>
 
+#include "proto_builder/oss/file.h"
 #include "proto_builder/oss/logging.h"
 #include "google/protobuf/descriptor.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace proto_builder {
 
@@ -123,7 +125,9 @@ class BufferWriter : public BuilderWriter {
   }
 
   // Write the contents 'from' to 'filename'.
-  absl::Status WriteFile(Where from, const std::string& filename) const;
+  absl::Status WriteFile(
+      Where from, const std::string& filename,
+      const file::oss::Options& options = file::oss::Defaults()) const;
 
   // Move contents 'from' 'to_writer'. Target 'from' will be empty afterwards.
   void MoveContents(Where from, BufferWriter* to_writer);
@@ -137,6 +141,57 @@ class BufferWriter : public BuilderWriter {
   CodeInfoCollector code_info_;
 };
 
+// READ: https://google.github.io/cpp-proto-builder#ChunkedBufferWriter
+// BuilderWriter that appends all writes into large per target chunks instead of
+// allocating a string per line. The chunks already hold the lines joined with
+// new-lines, so `Contents` and `WriteFile` need no per line work.
+class ChunkedBufferWriter : public BuilderWriter {
+ public:
+  // Ensure all targets (HEADER, SOURCE, INTERFACE) are present and empty.
+  explicit ChunkedBufferWriter(
+      const std::vector<std::string>& package_path = {});
+
+  void Write(Where to, const std::string& line) override;
+
+  // Access to the lines of the given target. The views remain valid for the
+  // lifetime of the writer.
+  absl::Span<const absl::string_view> Lines(Where from) const {
+    return buffer_.at(from).lines;
+  }
+
+  // Returns all lines of target 'from' joined by new-lines.
+  std::string Contents(Where from) const;
+
+  // Write the contents 'from' to 'filename'.
+  absl::Status WriteFile(
+      Where from, const std::string& filename,
+      const file::oss::Options& options = file::oss::Defaults()) const;
+
+  // Access to the CodeInfoCollector instance.
+  CodeInfoCollector* CodeInfo() final;
+  const CodeInfoCollector* CodeInfo() const final;
+
+ private:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    size_t capacity = 0;
+  };
+
+  struct Target {
+    std::vector<Chunk> chunks;
+    std::vector<absl::string_view> lines;
+  };
+
+  // The chunk contents of 'from' without the new-line after the last line.
+  std::vector<absl::string_view> Pieces(Where from) const;
+
+  std::map<Where, Target> buffer_;
+  CodeInfoCollector code_info_;
+};
+
 // READ: https://google.github.io/cpp-proto-builder#WrappingBuilderWriter
 // Base class for all wrapping writers.
 // This simplifies management of the wrapped BuilderWriter and automatically
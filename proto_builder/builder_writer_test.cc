@@ -20,12 +20,14 @@
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 
 namespace proto_builder {
 namespace {
 
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::IsEmpty;
 
 class WriterMock : public BuilderWriter, public CodeInfoCollector {
@@ -185,6 +187,37 @@ TEST_F(BuilderWriterTest, BufferWriter_MoveContents) {
   EXPECT_THAT(writer2.From(HEADER), ElementsAre("21", "11", "12", "22"));
 }
 
+TEST_F(BuilderWriterTest, ChunkedBufferWriter) {
+  ChunkedBufferWriter writer;
+  EXPECT_THAT(writer.Lines(HEADER), IsEmpty());
+  EXPECT_THAT(writer.Contents(HEADER), IsEmpty());
+  writer.Write(HEADER, "1");
+  writer.Write(HEADER, "");
+  writer.Write(SOURCE, "B");
+  writer.Write(HEADER, "3");
+  EXPECT_THAT(writer.Lines(HEADER), ElementsAre("1", "", "3"));
+  EXPECT_THAT(writer.Lines(SOURCE), ElementsAre("B"));
+  EXPECT_THAT(writer.Lines(INTERFACE), IsEmpty());
+  EXPECT_THAT(writer.Contents(HEADER), "1\n\n3");
+  EXPECT_THAT(writer.Contents(SOURCE), "B");
+}
+
+TEST_F(BuilderWriterTest, ChunkedBufferWriter_LargeContents) {
+  ChunkedBufferWriter writer;
+  BufferWriter expected;
+  const std::string long_line(100000, 'x');
+  for (int i = 0; i < 10000; ++i) {
+    const std::string line =
+        i % 1000 == 0 ? long_line : absl::StrCat("line ", i);
+    writer.Write(SOURCE, line);
+    expected.Write(SOURCE, line);
+  }
+  // Views into earlier chunks must survive adding more chunks.
+  EXPECT_THAT(writer.Lines(SOURCE), ElementsAreArray(expected.From(SOURCE)));
+  EXPECT_THAT(writer.Contents(SOURCE),
+              absl::StrJoin(expected.From(SOURCE), "\n"));
+}
+
 TEST_F(BuilderWriterTest, NoDoubleEmptyLines) {
   BufferWriter buffer_writer;
   NoDoubleEmptyLineWriter test_writer(&buffer_writer);
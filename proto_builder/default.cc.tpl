@@ -27,8 +27,9 @@ namespace {{NAMESPACE}} {
 // https://google.github.io/cpp-proto-builder/templates#BEGIN
 // {{#BUILDER}}
 {{#USE_BUILD}}
+{{#NOT_ARENA}}
 
-{{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::Build() const {
+{{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::Build() const& {
   if (ok()) {
     return {{ROOT_DATA}};
   } else {
@@ -36,28 +37,118 @@ namespace {{NAMESPACE}} {
   }
 }
 
+{{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::Build() && {
+  if (ok()) {
+    {{INVALIDATE_DATA}}
+    return std::move({{ROOT_DATA}});
+  } else {
+    return status_;
+  }
+}
+
 {{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::Consume() {
   if (ok()) {
+    {{INVALIDATE_DATA}}
     return std::move({{ROOT_DATA}});
   } else {
     data_.Clear();
+    {{INVALIDATE_DATA}}
     {{%Status}} result(std::move(status_));
     status_ = {{%Status}}();
     get_raw_data_ = true;
     return result;
   }
 }
+
+{{%StatusOr}}<std::unique_ptr<{{PROTO_TYPE}}>> {{CLASS_NAME}}::Release() {
+  {{%StatusOr}}<{{PROTO_TYPE}}> result = Consume();
+  if (result.ok()) {
+    return std::make_unique<{{PROTO_TYPE}}>(*std::move(result));
+  } else {
+    return result.status();
+  }
+}
+
+{{%Status}} {{CLASS_NAME}}::BuildInto({{PROTO_TYPE}}* out) {
+  if (ok()) {
+    // Swap only copies if `out` lives on a different arena.
+    out->Swap(&{{ROOT_DATA}});
+    {{ROOT_DATA}}.Clear();
+    {{INVALIDATE_DATA}}
+    return {{%Status}}();
+  } else {
+    return Consume().status();
+  }
+}
+{{/NOT_ARENA}}
+{{#USE_ARENA}}
+
+{{%StatusOr}}<const {{PROTO_TYPE}}*> {{CLASS_NAME}}::Build() const {
+  if (ok()) {
+    return {{ROOT_DATA}};
+  } else {
+    return status_;
+  }
+}
+
+{{%StatusOr}}<{{PROTO_TYPE}}*> {{CLASS_NAME}}::Consume() {
+  if (ok()) {
+    // Hand out the arena message and continue with a fresh one.
+    {{INVALIDATE_DATA}}
+    return std::exchange({{ROOT_DATA}},
+                         {{%Arena}}::CreateMessage<{{PROTO_TYPE}}>(arena()));
+  } else {
+    data_->Clear();
+    {{INVALIDATE_DATA}}
+    {{%Status}} result(std::move(status_));
+    status_ = {{%Status}}();
+    get_raw_data_ = true;
+    return result;
+  }
+}
+
+{{%Status}} {{CLASS_NAME}}::BuildInto({{PROTO_TYPE}}* out) {
+  if (ok()) {
+    // Swap only copies if `out` lives on a different arena.
+    out->Swap({{ROOT_DATA}});
+    {{ROOT_DATA}}->Clear();
+    {{INVALIDATE_DATA}}
+    return {{%Status}}();
+  } else {
+    return Consume().status();
+  }
+}
+{{/USE_ARENA}}
 {{/USE_BUILD}}
 {{#USE_STATUS}}
 
 {{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::MaybeGetRawData() const {
   if (get_raw_data_) {
+    {{#NOT_ARENA}}
     return data_;
+    {{/NOT_ARENA}}
+    {{#USE_ARENA}}
+    return *data_;
+    {{/USE_ARENA}}
   } else {
     return status_;
   }
 }
 
+{{%StatusOr}}<{{PROTO_TYPE}}> {{CLASS_NAME}}::MaybeReleaseRawData() && {
+  if (get_raw_data_) {
+    {{#NOT_ARENA}}
+    return std::move(data_);
+    {{/NOT_ARENA}}
+    {{#USE_ARENA}}
+    // The result does not live on the arena, so this copies.
+    return std::move(*data_);
+    {{/USE_ARENA}}
+  } else {
+    return std::move(status_);
+  }
+}
+
 {{CLASS_NAME}}& {{CLASS_NAME}}::UpdateStatus({{%Status+param}}) {
   status_ = std::move({{%Status%param}});
   if (status_.ok()) {
@@ -73,9 +164,16 @@ namespace {{NAMESPACE}} {
 {{#USE_VALIDATOR}}
 
 void {{CLASS_NAME}}::ValidateData() const {
-  if (status_.ok()) {
+  if (status_.ok() && !data_validated_) {
+    {{#NOT_ARENA}}
     status_ = {{%Validate}}(data_);
-    if (!status_.ok()) {
+    {{/NOT_ARENA}}
+    {{#USE_ARENA}}
+    status_ = {{%Validate}}(*data_);
+    {{/USE_ARENA}}
+    if (status_.ok()) {
+      data_validated_ = true;
+    } else {
       {{%LogSourceLocation}}
     }
   }
@@ -83,6 +181,12 @@ void {{CLASS_NAME}}::ValidateData() const {
 {{/USE_VALIDATOR}}
 
 // {{GENERATED_SOURCE_CODE}}
+{{#USE_VIEW}}
+// {{GENERATED_VIEW_SOURCE_CODE}}
+{{/USE_VIEW}}
+{{#USE_WRITER}}
+// {{GENERATED_WRITER_SOURCE_CODE}}
+{{/USE_WRITER}}
 // {{/BUILDER}}
 // https://google.github.io/cpp-proto-builder/templates#END
 
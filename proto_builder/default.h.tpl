@@ -25,15 +25,25 @@
 namespace {{NAMESPACE}} {
 {{/ALL_NAMESPACES}}
 
+{{#FORWARD_DECLARATIONS}}
+{{#FORWARD_DECLARATION}}
+class {{FORWARD_CLASS}};
+{{/FORWARD_DECLARATION}}
+
+{{/FORWARD_DECLARATIONS}}
 {{#BUILDER}}
+{{#NOT_POLICY}}
 class {{CLASS_NAME}}{{BASE_CLASSES}} {
  public:
   {{#NOT_STATUS}}
+  {{#NOT_ARENA}}
   {{CLASS_NAME}}() = default;
   explicit {{CLASS_NAME}}(const {{PROTO_TYPE}}& data) : data_(data) {}
-  explicit {{CLASS_NAME}}({{PROTO_TYPE}}&& data) : data_(data) {}
+  explicit {{CLASS_NAME}}({{PROTO_TYPE}}&& data) : data_(std::move(data)) {}
+  {{/NOT_ARENA}}
   {{/NOT_STATUS}}
   {{#USE_STATUS}}
+  {{#NOT_ARENA}}
   explicit {{CLASS_NAME}}({{%SourceLocation+param=value}})
       : source_location_({{%SourceLocation%param}}) {}
   explicit {{CLASS_NAME}}(const {{PROTO_TYPE}}& data,
@@ -41,15 +51,82 @@ class {{CLASS_NAME}}{{BASE_CLASSES}} {
       : source_location_({{%SourceLocation%param}}), data_(data) {}
   explicit {{CLASS_NAME}}({{PROTO_TYPE}}&& data,
                           {{%SourceLocation+param=value}})
-      : source_location_({{%SourceLocation%param}}), data_(data) {}
+      : source_location_({{%SourceLocation%param}}),
+        data_(std::move(data)) {}
+  {{/NOT_ARENA}}
+  {{#USE_ARENA}}
+  explicit {{CLASS_NAME}}({{%Arena}}* {{%Arena%param}},
+                          {{%SourceLocation+param=value}})
+      : source_location_({{%SourceLocation%param}}),
+        data_({{%Arena}}::CreateMessage<{{PROTO_TYPE}}>({{%Arena%param}})) {}
+  {{CLASS_NAME}}({{%Arena}}* {{%Arena%param}}, const {{PROTO_TYPE}}& data,
+                 {{%SourceLocation+param=value}})
+      : {{CLASS_NAME}}({{%Arena%param}}, {{%SourceLocation%param}}) {
+    *data_ = data;
+  }
+  // Leaves `other` with a fresh message on the same arena.
+  {{CLASS_NAME}}({{CLASS_NAME}}&& other)
+      : {{CLASS_NAME}}(other.arena(), other.source_location_) {
+    std::swap(data_, other.data_);
+    std::swap(status_, other.status_);
+    std::swap(get_raw_data_, other.get_raw_data_);
+    {{#USE_VALIDATOR}}
+    data_validated_ = other.data_validated_;
+    other.data_validated_ = false;
+    {{/USE_VALIDATOR}}
+  }
+  {{/USE_ARENA}}
   {{/USE_STATUS}}
+  {{#USE_ARENA}}
+  {{#NOT_STATUS}}
+  explicit {{CLASS_NAME}}({{%Arena}}* {{%Arena%param}})
+      : data_({{%Arena}}::CreateMessage<{{PROTO_TYPE}}>({{%Arena%param}})) {}
+  {{CLASS_NAME}}({{%Arena}}* {{%Arena%param}}, const {{PROTO_TYPE}}& data)
+      : {{CLASS_NAME}}({{%Arena%param}}) {
+    *data_ = data;
+  }
+  // Leaves `other` with a fresh message on the same arena.
+  {{CLASS_NAME}}({{CLASS_NAME}}&& other) : {{CLASS_NAME}}(other.arena()) {
+    std::swap(data_, other.data_);
+    {{#USE_VALIDATOR}}
+    data_validated_ = other.data_validated_;
+    other.data_validated_ = false;
+    {{/USE_VALIDATOR}}
+  }
+  {{/NOT_STATUS}}
+
+  // The data is owned by the arena, so copies would share it. Arena builders
+  // are move-constructible only.
+  {{CLASS_NAME}}(const {{CLASS_NAME}}&) = delete;
+  {{CLASS_NAME}}& operator=(const {{CLASS_NAME}}&) = delete;
+  {{CLASS_NAME}}& operator=({{CLASS_NAME}}&&) = delete;
+
+  // Without an arena the builder owns the data.
+  ~{{CLASS_NAME}}() {
+    if (arena() == nullptr) {
+      delete data_;
+    }
+  }
+
+  {{%Arena}}* arena() const { return data_->GetArena(); }
+  {{/USE_ARENA}}
   {{#USE_BUILD}}
 
-  {{%StatusOr}}<{{PROTO_TYPE}}> Build() const;
+  {{#NOT_ARENA}}
+  {{%StatusOr}}<{{PROTO_TYPE}}> Build() const&;
+  {{%StatusOr}}<{{PROTO_TYPE}}> Build() &&;
   {{%StatusOr}}<{{PROTO_TYPE}}> Consume();
+  {{%StatusOr}}<std::unique_ptr<{{PROTO_TYPE}}>> Release();
+  {{/NOT_ARENA}}
+  {{#USE_ARENA}}
+  {{%StatusOr}}<const {{PROTO_TYPE}}*> Build() const;
+  {{%StatusOr}}<{{PROTO_TYPE}}*> Consume();
+  {{/USE_ARENA}}
+  {{%Status}} BuildInto({{PROTO_TYPE}}* out);
   {{/USE_BUILD}}
   {{#USE_STATUS}}
   {{%StatusOr}}<{{PROTO_TYPE}}> MaybeGetRawData() const;
+  {{%StatusOr}}<{{PROTO_TYPE}}> MaybeReleaseRawData() &&;
   {{/USE_STATUS}}
   {{#USE_CONVERSION}}
 
@@ -62,7 +139,12 @@ class {{CLASS_NAME}}{{BASE_CLASSES}} {
     }
     {{/USE_STATUS}}
     {{#USE_CONVERSION}}
+    {{#NOT_ARENA}}
     return data_;
+    {{/NOT_ARENA}}
+    {{#USE_ARENA}}
+    return *data_;
+    {{/USE_ARENA}}
   }
   {{/USE_CONVERSION}}
   {{#USE_STATUS}}
@@ -80,6 +162,23 @@ class {{CLASS_NAME}}{{BASE_CLASSES}} {
   {{CLASS_NAME}}& UpdateStatus({{%Status+param}});
   {{/USE_STATUS}}
 
+  // Clears the data and status so that the builder can be reused. Memory that
+  // the data already allocated (strings, repeated fields) is kept.
+  {{CLASS_NAME}}& Reset() {
+    {{#NOT_ARENA}}
+    data_.Clear();
+    {{/NOT_ARENA}}
+    {{#USE_ARENA}}
+    data_->Clear();
+    {{/USE_ARENA}}
+    {{INVALIDATE_DATA}}
+    {{#USE_STATUS}}
+    status_ = {{%Status}}();
+    get_raw_data_ = true;
+    {{/USE_STATUS}}
+    return *this;
+  }
+
   // https://google.github.io/cpp-proto-builder/templates#BEGIN
 
   // {{GENERATED_HEADER_CODE}}
@@ -94,13 +193,244 @@ class {{CLASS_NAME}}{{BASE_CLASSES}} {
   {{#USE_STATUS}}
   const {{%SourceLocation}} source_location_;
   {{/USE_STATUS}}
+  {{#NOT_ARENA}}
   {{PROTO_TYPE}} data_;
+  {{/NOT_ARENA}}
+  {{#USE_ARENA}}
+  {{PROTO_TYPE}}* data_;
+  {{/USE_ARENA}}
   {{#USE_STATUS}}
   mutable {{%Status}} status_;
   bool get_raw_data_ = true;
   {{/USE_STATUS}}
+  {{#USE_VALIDATOR}}
+  // Whether `data_` passed validation since it was last changed.
+  mutable bool data_validated_ = false;
+  {{/USE_VALIDATOR}}
+};
+
+{{/NOT_POLICY}}
+{{#USE_POLICY}}
+// The checks are selected by `Policy`, see {{%CheckedPolicy}}.
+template <class Policy = {{%CheckedPolicy}}>
+class {{CLASS_NAME}}T{{BASE_CLASSES}} {
+ public:
+  {{#USE_VALIDATOR}}
+  static_assert(!Policy::kValidate || Policy::kTrackStatus,
+                "Validation requires a status.");
+
+  {{/USE_VALIDATOR}}
+  explicit {{CLASS_NAME}}T({{%SourceLocation+param=value}})
+      : source_location_({{%SourceLocation%param}}) {}
+  explicit {{CLASS_NAME}}T(const {{PROTO_TYPE}}& data,
+                           {{%SourceLocation+param=value}})
+      : source_location_({{%SourceLocation%param}}), data_(data) {}
+  explicit {{CLASS_NAME}}T({{PROTO_TYPE}}&& data,
+                           {{%SourceLocation+param=value}})
+      : source_location_({{%SourceLocation%param}}),
+        data_(std::move(data)) {}
+  {{#USE_BUILD}}
+
+  {{%StatusOr}}<{{PROTO_TYPE}}> Build() const& {
+    if (ok()) {
+      return {{ROOT_DATA}};
+    } else {
+      return status_;
+    }
+  }
+
+  {{%StatusOr}}<{{PROTO_TYPE}}> Build() && {
+    if (ok()) {
+      {{INVALIDATE_DATA}}
+      return std::move({{ROOT_DATA}});
+    } else {
+      return status_;
+    }
+  }
+
+  {{%StatusOr}}<{{PROTO_TYPE}}> Consume() {
+    if (ok()) {
+      {{INVALIDATE_DATA}}
+      return std::move({{ROOT_DATA}});
+    } else {
+      {{%Status}} result(std::move(status_));
+      Reset();
+      return result;
+    }
+  }
+
+  {{%StatusOr}}<std::unique_ptr<{{PROTO_TYPE}}>> Release() {
+    {{%StatusOr}}<{{PROTO_TYPE}}> result = Consume();
+    if (result.ok()) {
+      return std::make_unique<{{PROTO_TYPE}}>(*std::move(result));
+    } else {
+      return result.status();
+    }
+  }
+
+  {{%Status}} BuildInto({{PROTO_TYPE}}* out) {
+    if (ok()) {
+      // Swap only copies if `out` lives on a different arena.
+      out->Swap(&{{ROOT_DATA}});
+      {{ROOT_DATA}}.Clear();
+      {{INVALIDATE_DATA}}
+      return {{%Status}}();
+    } else {
+      return Consume().status();
+    }
+  }
+  {{/USE_BUILD}}
+
+  {{%StatusOr}}<{{PROTO_TYPE}}> MaybeGetRawData() const {
+    if (get_raw_data_) {
+      return data_;
+    } else {
+      return status_;
+    }
+  }
+
+  {{%StatusOr}}<{{PROTO_TYPE}}> MaybeReleaseRawData() && {
+    if (get_raw_data_) {
+      return std::move(data_);
+    } else {
+      return std::move(status_);
+    }
+  }
+  {{#USE_CONVERSION}}
+
+  operator const {{PROTO_TYPE}}&() const {  // NOLINT
+    if (!ok()) {
+      return {{PROTO_TYPE}}::default_instance();
+    }
+    return data_;
+  }
+  {{/USE_CONVERSION}}
+
+  bool ok() const {
+    if constexpr (Policy::kTrackStatus) {
+      {{VALIDATE_DATA}}
+      return status_.ok();
+    } else {
+      return true;
+    }
+  }
+
+  {{%Status}} status() const {
+    if constexpr (Policy::kTrackStatus) {
+      {{VALIDATE_DATA}}
+      return status_;
+    } else {
+      return {{%Status}}();
+    }
+  }
+
+  // Does nothing unless the policy tracks the status.
+  {{CLASS_NAME}}T& UpdateStatus({{%Status+param}}) {
+    if constexpr (Policy::kTrackStatus) {
+      status_ = std::move({{%Status%param}});
+      if (status_.ok()) {
+        get_raw_data_ = true;
+        {{VALIDATE_DATA}}
+      } else {
+        get_raw_data_ = false;
+        if constexpr (Policy::kSourceLocation) {
+          {{%LogSourceLocation}}
+        }
+      }
+    }
+    return *this;
+  }
+
+  // Clears the data and status so that the builder can be reused. Memory that
+  // the data already allocated (strings, repeated fields) is kept.
+  {{CLASS_NAME}}T& Reset() {
+    data_.Clear();
+    {{INVALIDATE_DATA}}
+    status_ = {{%Status}}();
+    get_raw_data_ = true;
+    return *this;
+  }
+
+  // https://google.github.io/cpp-proto-builder/templates#BEGIN
+
+  // {{GENERATED_HEADER_CODE}}
+  // https://google.github.io/cpp-proto-builder/templates#END
+  {{#USE_VALIDATOR}}
+
+ protected:
+  void ValidateData() const {
+    if constexpr (Policy::kValidate) {
+      if (status_.ok() && !data_validated_) {
+        status_ = {{%Validate}}(data_);
+        if (status_.ok()) {
+          data_validated_ = true;
+        } else if constexpr (Policy::kSourceLocation) {
+          {{%LogSourceLocation}}
+        }
+      }
+    }
+  }
+  {{/USE_VALIDATOR}}
+
+ private:
+  const {{%SourceLocation}} source_location_;
+  {{PROTO_TYPE}} data_;
+  mutable {{%Status}} status_;
+  bool get_raw_data_ = true;
+  {{#USE_VALIDATOR}}
+  // Whether `data_` passed validation since it was last changed.
+  mutable bool data_validated_ = false;
+  {{/USE_VALIDATOR}}
+};
+
+using {{CLASS_NAME}} = {{CLASS_NAME}}T<>;
+
+{{/USE_POLICY}}
+{{#USE_VIEW}}
+// Sets the fields of a {{PROTO_TYPE}} that is owned elsewhere.
+// This is usually an element that a builder added in place. The data must
+// outlive the view.
+class {{VIEW_NAME}} {
+ public:
+  // Every change resets `data_validated` unless that is null, so that a
+  // validating builder that owns the data validates it again.
+  explicit {{VIEW_NAME}}({{PROTO_TYPE}}* data, bool* data_validated = nullptr)
+      : data_(data), data_validated_(data_validated) {}
+
+  operator const {{PROTO_TYPE}}&() const {  // NOLINT
+    return *data_;
+  }
+
+  // {{GENERATED_VIEW_HEADER_CODE}}
+
+ private:
+  void InvalidateData() {
+    if (data_validated_ != nullptr) {
+      *data_validated_ = false;
+    }
+  }
+
+  {{PROTO_TYPE}}* data_;
+  bool* data_validated_;
+};
+
+{{/USE_VIEW}}
+{{#USE_WRITER}}
+// Writes {{PROTO_TYPE}} in wire format without creating the message.
+class {{WRITER_NAME}} {
+ public:
+  explicit {{WRITER_NAME}}(std::string* output) : writer_(output) {}
+  // Writes a sub message into `parent`. It is finished once destroyed.
+  {{WRITER_NAME}}({{%WireWriter}}* parent, int field_number)
+      : writer_(parent, field_number) {}
+
+  // {{GENERATED_WRITER_HEADER_CODE}}
+
+ private:
+  {{%WireWriter}} writer_;
 };
 
+{{/USE_WRITER}}
 {{/BUILDER}}
 {{#ALL_NAMESPACES}}
 }  // namespace {{NAMESPACE}}
@@ -0,0 +1,155 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/descriptor_graph.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "proto_builder/oss/logging.h"
+#include "absl/algorithm/container.h"
+
+namespace proto_builder {
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::FieldDescriptor;
+
+DescriptorGraph::DescriptorGraph(absl::Span<const Descriptor* const> roots) {
+  for (const Descriptor* root : roots) {
+    AddNode(PBCC_DIE_IF_NULL(root));
+  }
+  // Nodes get appended while their parents are processed, so this visits all
+  // reachable messages in breadth first order.
+  for (size_t id = 0; id < nodes_.size(); ++id) {
+    const Descriptor& descriptor = *nodes_[id].descriptor;
+    for (int i = 0; i < descriptor.field_count(); ++i) {
+      const FieldDescriptor& field = *PBCC_DIE_IF_NULL(descriptor.field(i));
+      if (field.cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+        continue;
+      }
+      Edge edge{
+          .field = &field,
+          .target = PBCC_DIE_IF_NULL(field.message_type()),
+          .kind = field.is_repeated() ? EdgeKind::kRepeated
+                                      : EdgeKind::kSingular,
+      };
+      if (field.is_map()) {
+        // The key cannot be a message, so only the value type is an edge.
+        const FieldDescriptor& value = *PBCC_DIE_IF_NULL(edge.target->field(1));
+        if (value.cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+          continue;
+        }
+        edge.target = PBCC_DIE_IF_NULL(value.message_type());
+        edge.kind = EdgeKind::kMapValue;
+      }
+      const int target = AddNode(edge.target);
+      nodes_[id].edges.push_back(edge);
+      nodes_[id].targets.push_back(target);
+    }
+  }
+  ComputeComponents();
+}
+
+int DescriptorGraph::AddNode(const Descriptor* descriptor) {
+  const auto [it, inserted] = index_.try_emplace(descriptor, nodes_.size());
+  if (inserted) {
+    nodes_.emplace_back().descriptor = descriptor;
+  }
+  return it->second;
+}
+
+// Tarjan's algorithm, iterative so that deeply nested protos cannot overflow
+// the stack. A component is recursive if it has more than one member or its
+// only member has a field of its own type.
+void DescriptorGraph::ComputeComponents() {
+  struct Frame {
+    int node;
+    size_t next_edge;
+  };
+  const int num_nodes = nodes_.size();
+  std::vector<int> order(num_nodes, -1);
+  std::vector<int> low_link(num_nodes);
+  std::vector<bool> on_stack(num_nodes);
+  std::vector<int> stack;
+  std::vector<Frame> calls;
+  int next_order = 0;
+  auto visit = [&](int node) {
+    order[node] = low_link[node] = next_order++;
+    stack.push_back(node);
+    on_stack[node] = true;
+    calls.push_back({node, 0});
+  };
+  for (int start = 0; start < num_nodes; ++start) {
+    if (order[start] != -1) {
+      continue;
+    }
+    visit(start);
+    while (!calls.empty()) {
+      Frame& frame = calls.back();
+      const int node = frame.node;
+      if (frame.next_edge < nodes_[node].targets.size()) {
+        const int target = nodes_[node].targets[frame.next_edge++];
+        if (order[target] == -1) {
+          visit(target);
+        } else if (on_stack[target]) {
+          low_link[node] = std::min(low_link[node], order[target]);
+        }
+        continue;
+      }
+      calls.pop_back();
+      if (!calls.empty()) {
+        const int parent = calls.back().node;
+        low_link[parent] = std::min(low_link[parent], low_link[node]);
+      }
+      if (low_link[node] != order[node]) {
+        continue;
+      }
+      // `node` is the root of a component: pop all of its members.
+      const auto root =
+          std::find(stack.rbegin(), stack.rend(), node).base() - 1;
+      const std::vector<int> members(root, stack.end());
+      stack.erase(root, stack.end());
+      const bool recursive = members.size() > 1 ||
+                             absl::c_linear_search(nodes_[node].targets, node);
+      for (int member : members) {
+        on_stack[member] = false;
+        nodes_[member].recursive = recursive;
+      }
+    }
+  }
+}
+
+const DescriptorGraph::Node* DescriptorGraph::Find(
+    const Descriptor& descriptor) const {
+  const auto it = index_.find(&descriptor);
+  return it == index_.end() ? nullptr : &nodes_[it->second];
+}
+
+absl::Span<const DescriptorGraph::Edge> DescriptorGraph::Edges(
+    const Descriptor& descriptor) const {
+  const Node* node = Find(descriptor);
+  if (node == nullptr) {
+    return {};
+  }
+  return node->edges;
+}
+
+bool DescriptorGraph::IsRecursive(const Descriptor& descriptor) const {
+  const Node* node = Find(descriptor);
+  return node == nullptr || node->recursive;
+}
+
+}  // namespace proto_builder
@@ -0,0 +1,90 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_DESCRIPTOR_GRAPH_H_
+#define PROTO_BUILDER_DESCRIPTOR_GRAPH_H_
+
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+
+namespace proto_builder {
+
+// Index over the graph of message types formed by their message fields. The
+// graph contains all messages reachable from the roots it is built from,
+// including messages from imported files.
+//
+// Besides the adjacency lists, the index holds which messages are recursive,
+// based on the strongly connected components (SCCs) of the graph.
+//
+// The graph is immutable once built, so it can be shared between threads.
+class DescriptorGraph {
+ public:
+  enum class EdgeKind {
+    kSingular,  // Non repeated message field.
+    kRepeated,  // Repeated message field (not a map).
+    kMapValue,  // Map field with a message value type.
+  };
+
+  struct Edge {
+    const ::google::protobuf::FieldDescriptor* field;
+    const ::google::protobuf::Descriptor* target;  // For maps: the value type.
+    EdgeKind kind;
+  };
+
+  explicit DescriptorGraph(
+      absl::Span<const ::google::protobuf::Descriptor* const> roots);
+
+  DescriptorGraph(const DescriptorGraph&) = delete;
+  DescriptorGraph& operator=(const DescriptorGraph&) = delete;
+
+  size_t size() const { return nodes_.size(); }
+
+  bool Contains(const ::google::protobuf::Descriptor& descriptor) const {
+    return index_.contains(&descriptor);
+  }
+
+  // The message fields of `descriptor` in field order. Empty for messages that
+  // are not part of the graph.
+  absl::Span<const Edge> Edges(
+      const ::google::protobuf::Descriptor& descriptor) const;
+
+  // Returns whether `descriptor` is part of a cycle, either through other
+  // messages or through one of its own fields. Messages that are not part of
+  // the graph are considered recursive.
+  bool IsRecursive(const ::google::protobuf::Descriptor& descriptor) const;
+
+ private:
+  struct Node {
+    const ::google::protobuf::Descriptor* descriptor;
+    std::vector<Edge> edges;
+    std::vector<int> targets;  // Node ids of `edges`.
+    bool recursive = false;
+  };
+
+  int AddNode(const ::google::protobuf::Descriptor* descriptor);
+  void ComputeComponents();
+  const Node* Find(const ::google::protobuf::Descriptor& descriptor) const;
+
+  std::vector<Node> nodes_;
+  absl::flat_hash_map<const ::google::protobuf::Descriptor*, int> index_;
+};
+
+}  // namespace proto_builder
+
+#endif  // PROTO_BUILDER_DESCRIPTOR_GRAPH_H_
@@ -0,0 +1,175 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/descriptor_graph.h"
+
+#include <string>
+#include <vector>
+
+#include "proto_builder/oss/parse_text_proto.h"
+#include "proto_builder/tests/extra_test_message.pb.h"
+#include "proto_builder/tests/test_import_message.pb.h"
+#include "proto_builder/tests/test_recursive_messages.pb.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/strings/str_cat.h"
+
+namespace proto_builder {
+namespace {
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::DescriptorPool;
+using ::proto_builder::oss::ParseTextProtoOrDie;
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::IsEmpty;
+
+using Kind = DescriptorGraph::EdgeKind;
+
+auto IsEdge(const Descriptor* target, Kind kind) {
+  return AllOf(Field(&DescriptorGraph::Edge::target, target),
+               Field(&DescriptorGraph::Edge::kind, kind));
+}
+
+// Chain -> Mid -> Leaf, Loop -> Loop, UsesCycle -> CycleA <-> CycleB
+constexpr char kGraphProto[] = R"pb(
+  name: "graph.proto"
+  package: "graph"
+  message_type {
+    name: "Chain"
+    field {
+      name: "mid" number: 1 label: LABEL_OPTIONAL type_name: ".graph.Mid"
+    }
+  }
+  message_type {
+    name: "Mid"
+    field {
+      name: "leaf" number: 1 label: LABEL_REPEATED type_name: ".graph.Leaf"
+    }
+    field {
+      name: "leaf2" number: 2 label: LABEL_OPTIONAL type_name: ".graph.Leaf"
+    }
+  }
+  message_type {
+    name: "Leaf"
+    field { name: "i" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+  }
+  message_type {
+    name: "Loop"
+    field {
+      name: "loop" number: 1 label: LABEL_OPTIONAL type_name: ".graph.Loop"
+    }
+  }
+  message_type {
+    name: "UsesCycle"
+    field {
+      name: "a" number: 1 label: LABEL_OPTIONAL type_name: ".graph.CycleA"
+    }
+  }
+  message_type {
+    name: "CycleA"
+    field {
+      name: "b" number: 1 label: LABEL_OPTIONAL type_name: ".graph.CycleB"
+    }
+  }
+  message_type {
+    name: "CycleB"
+    field {
+      name: "a" number: 1 label: LABEL_OPTIONAL type_name: ".graph.CycleA"
+    }
+  }
+)pb";
+
+class DescriptorGraphTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    file_ = pool_.BuildFile(ParseTextProtoOrDie(kGraphProto));
+    ASSERT_NE(file_, nullptr);
+  }
+
+  const Descriptor* Message(const std::string& name) const {
+    return pool_.FindMessageTypeByName(absl::StrCat("graph.", name));
+  }
+
+  DescriptorPool pool_;
+  const ::google::protobuf::FileDescriptor* file_ = nullptr;
+};
+
+TEST_F(DescriptorGraphTest, Edges) {
+  const DescriptorGraph graph({Message("Chain")});
+  EXPECT_EQ(graph.size(), 3);
+  EXPECT_TRUE(graph.Contains(*Message("Leaf")));
+  EXPECT_FALSE(graph.Contains(*Message("Loop")));
+  EXPECT_THAT(graph.Edges(*Message("Chain")),
+              ElementsAre(IsEdge(Message("Mid"), Kind::kSingular)));
+  EXPECT_THAT(graph.Edges(*Message("Mid")),
+              ElementsAre(IsEdge(Message("Leaf"), Kind::kRepeated),
+                          IsEdge(Message("Leaf"), Kind::kSingular)));
+  EXPECT_THAT(graph.Edges(*Message("Leaf")), IsEmpty());
+  EXPECT_THAT(graph.Edges(*Message("Loop")), IsEmpty());
+}
+
+TEST_F(DescriptorGraphTest, Components) {
+  std::vector<const Descriptor*> roots;
+  for (int i = 0; i < file_->message_type_count(); ++i) {
+    roots.push_back(file_->message_type(i));
+  }
+  const DescriptorGraph graph(roots);
+  EXPECT_EQ(graph.size(), 7);
+  EXPECT_FALSE(graph.IsRecursive(*Message("Chain")));
+  EXPECT_FALSE(graph.IsRecursive(*Message("Mid")));
+  EXPECT_FALSE(graph.IsRecursive(*Message("Leaf")));
+  EXPECT_TRUE(graph.IsRecursive(*Message("Loop")));
+  EXPECT_FALSE(graph.IsRecursive(*Message("UsesCycle")));
+  EXPECT_TRUE(graph.IsRecursive(*Message("CycleA")));
+  EXPECT_TRUE(graph.IsRecursive(*Message("CycleB")));
+}
+
+TEST_F(DescriptorGraphTest, UnknownMessage) {
+  const DescriptorGraph graph({Message("Leaf")});
+  EXPECT_FALSE(graph.Contains(*Message("Chain")));
+  EXPECT_THAT(graph.Edges(*Message("Chain")), IsEmpty());
+  EXPECT_TRUE(graph.IsRecursive(*Message("Chain")));
+}
+
+TEST(DescriptorGraphGeneratedTest, MapsAndImports) {
+  const DescriptorGraph graph({ImportImportMessage::descriptor()});
+  EXPECT_THAT(
+      graph.Edges(*ImportImportMessage::descriptor()),
+      ElementsAre(
+          IsEdge(ImportImportMessage::Sub::descriptor(), Kind::kSingular),
+          IsEdge(ImportImportMessage::Rep::descriptor(), Kind::kRepeated),
+          IsEdge(ExtraTestMessage::descriptor(), Kind::kSingular),
+          IsEdge(ExtraTestMessage::descriptor(), Kind::kRepeated),
+          IsEdge(ImportImportMessage::Value::descriptor(), Kind::kMapValue)));
+  EXPECT_TRUE(graph.Contains(*ExtraTestMessage::descriptor()));
+  EXPECT_FALSE(graph.IsRecursive(*ImportImportMessage::descriptor()));
+  EXPECT_TRUE(graph.IsRecursive(*ImportImportMessage::Sub::descriptor()));
+  EXPECT_TRUE(graph.IsRecursive(*ImportImportMessage::Rep::descriptor()));
+  EXPECT_FALSE(graph.IsRecursive(*ImportImportMessage::Value::descriptor()));
+}
+
+TEST(DescriptorGraphGeneratedTest, Recursive) {
+  const DescriptorGraph graph({TestMessageRecursiveB::descriptor()});
+  EXPECT_TRUE(graph.IsRecursive(*TestMessageRecursiveA::descriptor()));
+  EXPECT_TRUE(graph.IsRecursive(*TestMessageRecursiveB::descriptor()));
+}
+
+}  // namespace
+}  // namespace proto_builder
@@ -17,18 +17,23 @@
 #include "proto_builder/descriptor_util.h"
 
 #include <limits>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "proto_builder/oss/file.h"
 #include "proto_builder/oss/logging.h"
 #include "proto_builder/oss/sourcefile_database.h"
+#include "proto_builder/oss/trace.h"
 #include "proto_builder/oss/util.h"
 #include "proto_builder/template_builder.h"
 #include "google/protobuf/descriptor.h"
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -38,7 +43,8 @@
 namespace proto_builder {
 
 absl::StatusOr<std::vector<const ::google::protobuf::Descriptor*>> GetDescriptorsFrom(
-    const ::google::protobuf::FileDescriptor& file_desc, MessageSearchMode search_mode) {
+    const ::google::protobuf::FileDescriptor& file_desc, MessageSearchMode search_mode,
+    const DescriptorGraph* graph) {
   std::vector<const ::google::protobuf::Descriptor*> descriptors(file_desc.message_type_count());
   std::queue<const ::google::protobuf::Descriptor*> queue;
   // Collect the top level messages of each file. When 'recursive' is true,
@@ -56,96 +62,121 @@ absl::StatusOr<std::vector<const ::google::protobuf::Descriptor*>> GetDescriptor
       search_mode == MessageSearchMode::kAllTopLevel) {
     return descriptors;
   }
+  std::optional<DescriptorGraph> own_graph;
+  if (graph == nullptr) {
+    graph = &own_graph.emplace(descriptors);
+  }
   // Using BFS, traverse from the top level messages to collect all message
-  // types.
+  // types. Every message is visited once, so this is linear in the size of the
+  // graph.
+  absl::flat_hash_set<const ::google::protobuf::Descriptor*> selected(descriptors.begin(),
+                                                            descriptors.end());
+  absl::flat_hash_set<const ::google::protobuf::Descriptor*> visited = selected;
   while (!queue.empty()) {
     const ::google::protobuf::Descriptor* msg = queue.front();
     queue.pop();
-    for (int i = 0; i < msg->field_count(); ++i) {
-      const FieldDescriptor* field_desc = PBCC_DIE_IF_NULL(msg->field(i));
-      if (!field_desc) {
-        return absl::InternalError(absl::StrCat(
-            "FieldDescriptor (", i, ") is nullptr: ", msg->full_name()));
-      }
-      if (field_desc->type() != FieldDescriptor::Type::TYPE_MESSAGE) {
-        continue;
-      }
-      const bool is_map = field_desc->is_map();
-      const bool is_repeated = field_desc->is_repeated();
-      if (is_map) {
-        // Maps are represented as messages. The key cannot be a message, so
-        // only value entry types are checked. Note maps are not recursive.
-        // As a result, they are not traversed further.
-        const ::google::protobuf::Descriptor* message_type = field_desc->message_type();
-        if (!message_type) {
-          return absl::InternalError(absl::StrCat(
-              "Descriptor for map is nullptr: ", field_desc->full_name()));
-        }
-        const FieldDescriptor* value_type = message_type->field(1);
-        if (!value_type) {
-          return absl::InternalError(
-              absl::StrCat("FieldDescriptor for map value is nullptr: ",
-                           field_desc->full_name()));
-        }
-        if (value_type->type() != FieldDescriptor::Type::TYPE_MESSAGE) {
-          continue;
-        }
-        // Switch to value type but do not change is_map or is_repeated.
-        field_desc = value_type;
-      }
-      const ::google::protobuf::Descriptor* msg_desc = field_desc->message_type();
-      if (!msg_desc || absl::c_linear_search(descriptors, msg_desc)) {
+    for (const DescriptorGraph::Edge& edge : graph->Edges(*msg)) {
+      // Maps are represented as messages. The key cannot be a message, so
+      // the edge of a map goes to its value type. Groups are not traversed.
+      if (edge.kind != DescriptorGraph::EdgeKind::kMapValue &&
+          edge.field->type() != FieldDescriptor::Type::TYPE_MESSAGE) {
         continue;
       }
-      if (msg_desc->file() != &file_desc) {
+      if (edge.target->file() != &file_desc) {
         continue;  // Do not generate builders for imported messages.
       }
-      if (is_map || is_repeated ||
-          search_mode == MessageSearchMode::kTransitiveAll) {
-        descriptors.push_back(msg_desc);
+      if ((edge.kind != DescriptorGraph::EdgeKind::kSingular ||
+           search_mode == MessageSearchMode::kTransitiveAll) &&
+          selected.insert(edge.target).second) {
+        descriptors.push_back(edge.target);
+      }
+      if (visited.insert(edge.target).second) {
+        queue.emplace(edge.target);
       }
-      queue.emplace(msg_desc);
     }
   }
   return descriptors;
 }
 
+namespace {
+
+// proto.first contains the message list for which builder(s) will be
+// generated. A "*" signifies a message list containing the top level messages
+// from the first file. A "**" signifies a message list containing all
+// messages reachable from the top level messages in the first file including
+// the top level messages.
+std::pair<std::string, std::string> SplitProtoFlag(
+    absl::string_view proto_flag) {
+  return absl::StrSplit(proto_flag, absl::MaxSplits(':', 1));
+}
+
+MessageSearchMode GetSearchMode(absl::string_view selector) {
+  if (selector == "**") {
+    return MessageSearchMode::kTransitiveAll;
+  }
+  if (selector == "*+") {
+    return MessageSearchMode::kTransitiveRepeated;
+  }
+  if (selector == "*") {
+    return MessageSearchMode::kAllTopLevel;
+  }
+  return MessageSearchMode::kExplicit;
+}
+
+}  // namespace
+
+std::vector<std::string> DescriptorUtil::GetProtoFlagFiles(
+    absl::string_view proto_flag) {
+  return absl::StrSplit(SplitProtoFlag(proto_flag).second, ',',
+                        absl::SkipEmpty());
+}
+
+absl::StatusOr<std::shared_ptr<const oss::SourceFileDatabase>>
+DescriptorUtil::LoadDatabase(const std::vector<std::string>& proto_files,
+                             const std::vector<std::string>& proto_paths,
+                             const std::vector<std::string>& descriptor_sets) {
+  std::shared_ptr<const oss::SourceFileDatabase> proto_db;
+  if (descriptor_sets.empty()) {
+    proto_db = oss::SourceFileDatabase::New(proto_files, proto_paths);
+  } else {
+    proto_db = oss::SourceFileDatabase::NewFromDescriptorSets(
+        descriptor_sets, proto_files, proto_paths,
+        oss::SourceFileDatabase::GetDescriptorSetMmapFlag());
+  }
+  if (!proto_db || !proto_db->LoadedSuccessfully()) {
+    return absl::NotFoundError(absl::StrCat(
+        "Could not load proto_db: (", absl::StrJoin(proto_files, ","), ")"));
+  }
+  return proto_db;
+}
+
 absl::Status DescriptorUtil::LoadDescriptors(
     absl::string_view proto_flag, std::vector<std::string> proto_files,
-    std::vector<std::string> proto_paths) {
-  // proto.first contains the message list for which builder(s) will be
-  // generated. A "*" signifies a message list containing the top level messages
-  // from the first file. A "**" signifies a message list containing all
-  // messages reachable from the top level messages in the first file including
-  // the top level messages.
-  const std::pair<std::string, std::string> proto =
-      absl::StrSplit(proto_flag, absl::MaxSplits(':', 1));
-  search_mode_ = [proto] {
-    if (proto.first == "**") {
-      return MessageSearchMode::kTransitiveAll;
-    }
-    if (proto.first == "*+") {
-      return MessageSearchMode::kTransitiveRepeated;
-    }
-    if (proto.first == "*") {
-      return MessageSearchMode::kAllTopLevel;
-    }
-    return MessageSearchMode::kExplicit;
-  }();
-  // Add the files from the proto flag and check they can be loaded.
-  for (const auto& proto_file :
-       absl::StrSplit(proto.second, ',', absl::SkipEmpty())) {
-    if (!file::oss::Readable(proto_file).ok()) {
+    std::vector<std::string> proto_paths,
+    std::vector<std::string> descriptor_sets) {
+  // Add the files from the proto flag and check they can be loaded. Files
+  // taken from descriptor sets do not need to be present.
+  for (const auto& proto_file : GetProtoFlagFiles(proto_flag)) {
+    if (descriptor_sets.empty() && !file::oss::Readable(proto_file).ok()) {
       return absl::NotFoundError(
           absl::StrCat("Proto file not readable: '", proto_file, "'"));
     }
     proto_files.emplace_back(proto_file);
   }
-  proto_db_ = oss::SourceFileDatabase::New(proto_files, proto_paths);
-  if (!proto_db_ || !proto_db_->LoadedSuccessfully()) {
-    return absl::NotFoundError(absl::StrCat(
-        "Could not load proto_db: (", absl::StrJoin(proto_files, ","), ")"));
+  auto [status, proto_db] = UnpackStatusOrDefault(
+      LoadDatabase(proto_files, proto_paths, descriptor_sets));
+  if (!status.ok()) {
+    return status;
   }
+  return SelectDescriptors(SplitProtoFlag(proto_flag).first, proto_files,
+                           std::move(proto_db));
+}
+
+absl::Status DescriptorUtil::SelectDescriptors(
+    absl::string_view selector, const std::vector<std::string>& proto_files,
+    std::shared_ptr<const oss::SourceFileDatabase> proto_db) {
+  proto_db_ = std::move(proto_db);
+  search_mode_ = GetSearchMode(selector);
   if (search_mode_ != MessageSearchMode::kExplicit) {
     // We explicitly only generate builders for descriptors in the first file in
     // the proto file list, as it simplifies the builder story if all the
@@ -157,13 +188,18 @@ absl::Status DescriptorUtil::LoadDescriptors(
     }
     const std::string stripped = proto_files[0];
     const ::google::protobuf::FileDescriptor* file_desc =
-        proto_db_->pool()->FindFileByName(stripped);
+        proto_db_->FindFileByName(stripped);
     if (!file_desc) {
       return absl::NotFoundError(
           absl::StrCat("FileDescriptor is nullptr for: '", stripped, "'"));
     }
-    if (auto [status, descriptors] =
-            UnpackStatusOrDefault(GetDescriptorsFrom(*file_desc, search_mode_));
+    std::vector<const ::google::protobuf::Descriptor*> top_level;
+    for (int i = 0; i < file_desc->message_type_count(); ++i) {
+      top_level.push_back(file_desc->message_type(i));
+    }
+    graph_ = std::make_unique<const DescriptorGraph>(top_level);
+    if (auto [status, descriptors] = UnpackStatusOrDefault(
+            GetDescriptorsFrom(*file_desc, search_mode_, graph_.get()));
         !status.ok()) {
       return status;
     } else {
@@ -172,7 +208,7 @@ absl::Status DescriptorUtil::LoadDescriptors(
     }
   } else {
     std::vector<const ::google::protobuf::Descriptor*> descriptors;
-    for (auto name : absl::StrSplit(proto.first, ',')) {
+    for (auto name : absl::StrSplit(selector, ',')) {
       const ::google::protobuf::Descriptor* descriptor =
           proto_db_->pool()->FindMessageTypeByName(std::string(name));
       if (!descriptor) {
@@ -181,6 +217,7 @@ absl::Status DescriptorUtil::LoadDescriptors(
       }
       descriptors.push_back(descriptor);
     }
+    graph_ = std::make_unique<const DescriptorGraph>(descriptors);
     descriptors_ = std::move(descriptors);
     return absl::OkStatus();
   }
@@ -188,12 +225,33 @@ absl::Status DescriptorUtil::LoadDescriptors(
 
 absl::StatusOr<DescriptorUtil> DescriptorUtil::Load(
     absl::string_view proto_flag, std::vector<std::string> proto_files,
-    std::vector<std::string> proto_paths) {
+    std::vector<std::string> proto_paths,
+    std::vector<std::string> descriptor_sets) {
+  oss::TraceScope trace("DescriptorUtil::Load");
+  trace.AddArg("proto", proto_flag);
+  DescriptorUtil result;
+  absl::Status s = result.LoadDescriptors(proto_flag, proto_files, proto_paths,
+                                          descriptor_sets);
+  if (!s.ok()) {
+    return s;
+  }
+  trace.AddArg("messages", result.descriptors().size());
+  return result;
+}
+
+absl::StatusOr<DescriptorUtil> DescriptorUtil::Select(
+    absl::string_view proto_flag,
+    std::shared_ptr<const oss::SourceFileDatabase> proto_db) {
+  oss::TraceScope trace("DescriptorUtil::Select");
+  trace.AddArg("proto", proto_flag);
   DescriptorUtil result;
-  absl::Status s = result.LoadDescriptors(proto_flag, proto_files, proto_paths);
+  absl::Status s = result.SelectDescriptors(SplitProtoFlag(proto_flag).first,
+                                            GetProtoFlagFiles(proto_flag),
+                                            std::move(proto_db));
   if (!s.ok()) {
     return s;
   }
+  trace.AddArg("messages", result.descriptors().size());
   return result;
 }
 
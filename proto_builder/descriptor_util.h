@@ -17,10 +17,12 @@
 #ifndef PROTO_BUILDER_DESCRIPTOR_UTIL_H_
 #define PROTO_BUILDER_DESCRIPTOR_UTIL_H_
 
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "proto_builder/descriptor_graph.h"
 #include "proto_builder/oss/sourcefile_database.h"
 #include "google/protobuf/descriptor.h"
 #include "absl/status/statusor.h"
@@ -35,16 +37,41 @@ enum class MessageSearchMode {
   kTransitiveAll = 3,       // All messages (full transitive closure).
 };
 
+// Selects the messages of `file_desc` for `search_mode`. The transitive modes
+// traverse `graph`, which must contain the top level messages of `file_desc`.
+// If `graph` is nullptr, then a graph is built from those messages.
 absl::StatusOr<std::vector<const ::google::protobuf::Descriptor*>> GetDescriptorsFrom(
-    const ::google::protobuf::FileDescriptor& file_desc, MessageSearchMode search_mode);
+    const ::google::protobuf::FileDescriptor& file_desc, MessageSearchMode search_mode,
+    const DescriptorGraph* graph = nullptr);
 
 class DescriptorUtil {
  public:
   enum class DefaultWillNotWork { kDefaultWillNotWork = 0 };
 
+  // Loads the descriptors selected by `proto_flag`. If `descriptor_sets` is
+  // not empty, then the proto files are taken from those serialized
+  // FileDescriptorSets instead of being parsed from their sources.
   static absl::StatusOr<DescriptorUtil> Load(
       absl::string_view proto_flag, std::vector<std::string> proto_files,
-      std::vector<std::string> proto_paths);
+      std::vector<std::string> proto_paths,
+      std::vector<std::string> descriptor_sets = {});
+
+  // Loads `proto_files` into a database that can be shared by many `Select`
+  // calls, so that files used by multiple selections are only loaded once.
+  static absl::StatusOr<std::shared_ptr<const oss::SourceFileDatabase>>
+  LoadDatabase(const std::vector<std::string>& proto_files,
+               const std::vector<std::string>& proto_paths,
+               const std::vector<std::string>& descriptor_sets = {});
+
+  // Selects the descriptors for `proto_flag` from `proto_db`, which must have
+  // loaded the files named in `proto_flag` (see `GetProtoFlagFiles`).
+  static absl::StatusOr<DescriptorUtil> Select(
+      absl::string_view proto_flag,
+      std::shared_ptr<const oss::SourceFileDatabase> proto_db);
+
+  // Returns the files named in `proto_flag` ("<messages>:<file>[,<file>]").
+  static std::vector<std::string> GetProtoFlagFiles(
+      absl::string_view proto_flag);
 
   explicit DescriptorUtil(DefaultWillNotWork) {}
   DescriptorUtil(DescriptorUtil&&) = default;
@@ -54,6 +81,9 @@ class DescriptorUtil {
     return descriptors_;
   }
 
+  // The graph of all messages reachable from the loaded messages.
+  const DescriptorGraph* graph() const { return graph_.get(); }
+
   std::set<std::string> GetFullNames() const;
 
  private:
@@ -61,11 +91,17 @@ class DescriptorUtil {
 
   absl::Status LoadDescriptors(absl::string_view proto_flag,
                                std::vector<std::string> proto_files,
-                               std::vector<std::string> proto_paths);
+                               std::vector<std::string> proto_paths,
+                               std::vector<std::string> descriptor_sets);
+
+  absl::Status SelectDescriptors(
+      absl::string_view selector, const std::vector<std::string>& proto_files,
+      std::shared_ptr<const oss::SourceFileDatabase> proto_db);
 
-  std::unique_ptr<const oss::SourceFileDatabase> proto_db_;
+  std::shared_ptr<const oss::SourceFileDatabase> proto_db_;
   MessageSearchMode search_mode_;
   std::vector<const ::google::protobuf::Descriptor*> descriptors_;
+  std::unique_ptr<const DescriptorGraph> graph_;
 };
 
 }  // namespace proto_builder
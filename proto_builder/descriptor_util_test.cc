@@ -21,19 +21,23 @@
 #include <vector>
 
 #include "proto_builder/oss/file.h"
+#include "proto_builder/oss/parse_text_proto.h"
 #include "proto_builder/oss/util.h"
 #include "proto_builder/tests/test_import_message.pb.h"
+#include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "gmock/gmock.h"
 // Placeholder for testing header.
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
 namespace proto_builder {
 namespace {
 
+using ::proto_builder::oss::ParseTextProtoOrDie;
 using ::testing::ElementsAre;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
@@ -93,6 +97,36 @@ TEST_F(DescriptorUtilTest, GetDescriptorsFrom) {
                   ImportImportMessage::Value::descriptor())));
 }
 
+TEST_F(DescriptorUtilTest, GetDescriptorsFromSingularCycle) {
+  // Messages that are only used in singular fields are not selected by "*+",
+  // but still traversed. Cycles among them must not be traversed repeatedly.
+  const ::google::protobuf::FileDescriptorProto file = ParseTextProtoOrDie(R"pb(
+    name: "cycle.proto"
+    package: "cycle"
+    message_type {
+      name: "Top"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type_name: "A" }
+      nested_type {
+        name: "A"
+        field { name: "b" number: 1 label: LABEL_OPTIONAL type_name: "B" }
+      }
+      nested_type {
+        name: "B"
+        field { name: "a" number: 1 label: LABEL_OPTIONAL type_name: "A" }
+        field { name: "r" number: 2 label: LABEL_REPEATED type_name: "R" }
+      }
+      nested_type { name: "R" }
+    }
+  )pb");
+  ::google::protobuf::DescriptorPool pool;
+  const ::google::protobuf::FileDescriptor* file_desc = pool.BuildFile(file);
+  ASSERT_NE(file_desc, nullptr);
+  const ::google::protobuf::Descriptor* top = file_desc->message_type(0);
+  EXPECT_THAT(
+      GetDescriptorsFrom(*file_desc, MessageSearchMode::kTransitiveRepeated),
+      IsOkAndHolds(ElementsAre(top, top->FindNestedTypeByName("R"))));
+}
+
 TEST_F(DescriptorUtilTest, LoadDescriptorsErrors) {
   // Load errors
   EXPECT_THAT(TestLoadDescriptors("NA", {}),
@@ -146,5 +180,46 @@ TEST_F(DescriptorUtilTest, LoadDescriptors) {
           MessageSearchMode::kTransitiveAll)));
 }
 
+TEST_F(DescriptorUtilTest, GetProtoFlagFiles) {
+  EXPECT_THAT(DescriptorUtil::GetProtoFlagFiles("*"), ElementsAre());
+  EXPECT_THAT(DescriptorUtil::GetProtoFlagFiles("*+:a.proto"),
+              ElementsAre("a.proto"));
+  EXPECT_THAT(DescriptorUtil::GetProtoFlagFiles("my.Type:a.proto,b/c.proto"),
+              ElementsAre("a.proto", "b/c.proto"));
+}
+
+TEST_F(DescriptorUtilTest, SelectFromSharedDatabase) {
+  const std::string proto_file =
+      "proto_builder/tests/test_import_message.proto";
+  auto [status, proto_db] = UnpackStatusOrDefault(DescriptorUtil::LoadDatabase(
+      {proto_file}, {file::oss::JoinPath(getenv("TEST_SRCDIR"), "")}));
+  ASSERT_OK(status);
+  auto [status_1, transitive] = UnpackStatusOrDefault(
+      DescriptorUtil::Select(absl::StrCat("*+:", proto_file), proto_db),
+      DescriptorUtil::DefaultWillNotWork::kDefaultWillNotWork);
+  ASSERT_OK(status_1);
+  EXPECT_EQ(transitive.search_mode(), MessageSearchMode::kTransitiveRepeated);
+  EXPECT_THAT(transitive.GetFullNames(),
+              ElementsAre("proto_builder.ImportImportMessage",
+                          "proto_builder.ImportImportMessage.Rep",
+                          "proto_builder.ImportImportMessage.Value"));
+  auto [status_2, explicit_messages] = UnpackStatusOrDefault(
+      DescriptorUtil::Select("proto_builder.ImportImportMessage.Sub", proto_db),
+      DescriptorUtil::DefaultWillNotWork::kDefaultWillNotWork);
+  ASSERT_OK(status_2);
+  EXPECT_THAT(explicit_messages.GetFullNames(),
+              ElementsAre("proto_builder.ImportImportMessage.Sub"));
+  // Both selections share the same pool.
+  EXPECT_EQ(transitive.descriptors()[0]->file()->pool(),
+            explicit_messages.descriptors()[0]->file()->pool());
+
+  EXPECT_THAT(DescriptorUtil::Select("*", proto_db),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "At least one proto_files required, none given"));
+  EXPECT_THAT(DescriptorUtil::Select("NA", proto_db),
+              StatusIs(absl::StatusCode::kNotFound,
+                       "FieldDescriptor not found for: 'NA'"));
+}
+
 }  // namespace
 }  // namespace proto_builder
@@ -18,6 +18,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 
 #include "google/protobuf/compiler/cpp/cpp_helpers.h"
 #include "proto_builder/builder_writer.h"
@@ -322,6 +323,77 @@ bool FieldBuilder::UseMapInsert() const {
   return data_.field.is_map() && (UseInitializerList() || !UseForeachAdd());
 }
 
+bool FieldBuilder::UseMoveOverload() const {
+  if (data_.make_interface || data_.raw_field_options.override()) {
+    return false;
+  }
+  if (!UseHeader() || !UseSource() || UseTemplate()) {
+    return false;
+  }
+  if (!options_.value().empty() || !options_.conversion().empty()) {
+    return false;
+  }
+  const FieldDescriptor& value_field =
+      data_.field.is_map() ? *GetKeyValueTypes(data_.field).second
+                           : data_.field;
+  if (value_field.cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+      value_field.cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    return false;
+  }
+  return GetRawCppType() == GetFieldType(data_.field) &&
+         ParameterType(true) == Decorate(true, ParameterType(false));
+}
+
+bool FieldBuilder::UseSpanOverload() const {
+  if (!data_.first_method || data_.make_interface ||
+      data_.raw_field_options.override()) {
+    return false;
+  }
+  if (!data_.field.is_repeated() || data_.field.is_map()) {
+    return false;
+  }
+  if (!UseHeader() || !UseSource() || UseTemplate()) {
+    return false;
+  }
+  if (!options_.value().empty() || !options_.conversion().empty() ||
+      !data_.raw_field_options.predicate().empty() ||
+      options_.add_source_location()) {
+    return false;
+  }
+  switch (data_.field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_BOOL:
+      break;
+    default:
+      return false;
+  }
+  return GetRawCppType() == GetFieldType(data_.field) &&
+         data_.config.GetTypeInfo("%Span", ProtoBuilderTypeInfo::kSpecial);
+}
+
+bool FieldBuilder::IsTrivialSetter() const {
+  return options_.conversion().empty() && options_.predicate().empty() &&
+         !options_.add_source_location() && options_.source_include().empty();
+}
+
+bool FieldBuilder::UseInlineSetter() const {
+  if (!UseHeader() || !UseSource()) {
+    return false;
+  }
+  if (data_.use_policy) {
+    // Class templates need the definitions in the header.
+    return true;
+  }
+  // Interfaces declare the setters as overrides.
+  return data_.inline_trivial_setters && !data_.make_interface &&
+         IsTrivialSetter();
+}
+
 std::string FieldBuilder::CamelCaseFieldName(const std::string& name) const {
   return absl::StrCat(data_.name_parent,
                       !name.empty() ? name : CamelCaseName(data_.field));
@@ -395,10 +467,12 @@ std::string FieldBuilder::MethodName() const {
   }
 }
 
-std::string FieldBuilder::MethodParam(Where to) const {
+std::string FieldBuilder::MethodParam(Where to, bool rvalue) const {
   std::string param;
   if (options_.value().empty()) {
-    param = absl::StrCat(ParameterType(true), " ",
+    param = absl::StrCat(rvalue ? absl::StrCat(ParameterType(false), "&&")
+                                : ParameterType(true),
+                         " ",
                          data_.field.is_map() ? "key_value_pair" : "value",
                          UseForeach() ? "s" : "");
   }
@@ -471,6 +545,15 @@ void FieldBuilder::WriteDeclaration(Where to) const {
                                            : "";
   Write(to, prefix, data_.class_name, "& ", MethodName(), "(",
         MethodParam(HEADER), ")", suffix, ";");
+  if (to != INTERFACE && UseMoveOverload()) {
+    Write(to, data_.class_name, "& ", MethodName(), "(",
+          MethodParam(HEADER, /*rvalue=*/true), ");");
+  }
+  if (to != INTERFACE && UseSpanOverload()) {
+    Write(to, data_.class_name, "& ", MethodName(), "(",
+          data_.config.GetExpandedType("%Span"), "<const ",
+          GetFieldType(data_.field), "> values);");
+  }
   if (!data_.make_interface) {
     WriteSetFromBuilder();
   }
@@ -500,7 +583,22 @@ void FieldBuilder::WriteSetFromBuilder() const {
   Write(HEADER, "            decltype(&Builder::MaybeGetRawData), Builder>,");
   Write(HEADER, "        absl::StatusOr<", type, ">>>>");
   Write(HEADER, data_.class_name, "& ", MethodName(), "(", params, ") {");
-  Write(HEADER, "  auto value = std::move(builder).MaybeGetRawData();");
+  // Builders that have `MaybeReleaseRawData() &&` move their data into the
+  // field with the rvalue setter, so composing builders does not copy the
+  // nested message. Others only need the documented `MaybeGetRawData()`. The
+  // generic lambda detects the method without a helper outside the class.
+  Write(HEADER, "  auto release = [](auto* b)");
+  Write(HEADER, "      -> decltype(std::move(*b).MaybeReleaseRawData()) {");
+  Write(HEADER, "    return std::move(*b).MaybeReleaseRawData();");
+  Write(HEADER, "  };");
+  Write(HEADER, "  auto value = [&] {");
+  Write(HEADER, "    if constexpr (std::is_invocable_v<decltype(release), "
+                "Builder*>) {");
+  Write(HEADER, "      return release(&builder);");
+  Write(HEADER, "    } else {");
+  Write(HEADER, "      return builder.MaybeGetRawData();");
+  Write(HEADER, "    }");
+  Write(HEADER, "  }();");
   Write(HEADER, "  if (value.ok()) {");
   // We do not write conversions or predicates here since they will be handled
   // by the original setter.
@@ -513,8 +611,73 @@ void FieldBuilder::WriteSetFromBuilder() const {
   Write(HEADER, "");
 }
 
-void FieldBuilder::WriteBody(Where to) const {
+void FieldBuilder::WriteSpanImplementation(Where to) const {
   const std::string field_name = google::protobuf::compiler::cpp::FieldName(&data_.field);
+  const std::string function_name =
+      to == HEADER ? MethodName()
+                   : absl::StrCat(data_.class_name, "::", MethodName());
+  Write(to, "");
+  Write(to, data_.class_name, "& ", function_name, "(",
+        data_.config.GetExpandedType("%Span"), "<const ",
+        GetFieldType(data_.field), "> values) {");
+  WriteInvalidateData(to);
+  // RepeatedField::Add(begin, end) reserves once and copies all values.
+  Write(to, "  ", data_.data_parent, "mutable_", field_name,
+        "()->Add(values.begin(), values.end());");
+  Write(to, "  return *this;");
+  Write(to, "}");
+  Write(to, "");
+}
+
+void FieldBuilder::WriteViewAccessor(Where to) const {
+  const std::string field_name = google::protobuf::compiler::cpp::FieldName(&data_.field);
+  std::string method = absl::StrCat(MethodName(), "Builder(");
+  std::string param;
+  std::string element =
+      absl::StrCat(data_.data_parent, "add_", field_name, "()");
+  if (!data_.field.is_repeated()) {
+    method = absl::StrCat("Mutable", CamelCaseFieldName(options_.name()), "(");
+    element = absl::StrCat(data_.data_parent, "mutable_", field_name, "()");
+  } else if (data_.field.is_map()) {
+    const FieldDescriptor* key_type = GetKeyValueTypes(data_.field).first;
+    const bool decorate = key_type->type() == FieldDescriptor::TYPE_STRING;
+    param = absl::StrCat(Decorate(decorate, GetFieldType(*key_type)), " key");
+    element = absl::StrCat("&(*", data_.data_parent, "mutable_", field_name,
+                           "())[key]");
+  }
+  if (to == SOURCE) {
+    Write(HEADER, data_.nested_view, " ", method, param, ");");
+    method = absl::StrCat(data_.class_name, "::", method);
+  }
+  Write(to, "");
+  Write(to, data_.nested_view, " ", method, param, ") {");
+  WriteInvalidateData(to);
+  if (!data_.view_validation_state.empty()) {
+    absl::StrAppend(&element, ", ", data_.view_validation_state);
+  }
+  Write(to, "  return ", data_.nested_view, "(", element, ");");
+  Write(to, "}");
+  Write(to, "");
+}
+
+void FieldBuilder::WriteInlineImplementation() const {
+  WriteImplementation(HEADER);
+  if (UseMoveOverload()) {
+    WriteImplementation(HEADER, /*rvalue=*/true);
+  }
+  if (UseSpanOverload()) {
+    WriteSpanImplementation(HEADER);
+  }
+  WriteSetFromBuilder();
+  if (!data_.nested_view.empty()) {
+    WriteViewAccessor(HEADER);
+  }
+}
+
+void FieldBuilder::WriteBody(Where to, bool rvalue) const {
+  const std::string field_name = google::protobuf::compiler::cpp::FieldName(&data_.field);
+  const std::string value =
+      rvalue ? absl::StrCat("std::move(", SetValue(), ")") : SetValue();
   if (UseMapInsert()) {
     if (UseForeach()) {
       if (options_.conversion().empty()) {
@@ -524,7 +687,7 @@ void FieldBuilder::WriteBody(Where to) const {
       }
     } else {
       Write(to, "  ", data_.data_parent, "mutable_", field_name, "()->insert(",
-            SetValue(), ");");
+            value, ");");
       return;
     }
   }
@@ -533,9 +696,18 @@ void FieldBuilder::WriteBody(Where to) const {
         absl::StrCat(data_.data_parent, "add_", field_name);
     const std::string add_value =
         IsMessage(data_.field)
-            ? absl::StrCat("*", add_method, "() = ", SetValue(), ";")
-            : absl::StrCat(add_method, "(", SetValue(), ");");
+            ? absl::StrCat("*", add_method, "() = ", value, ";")
+            : absl::StrCat(add_method, "(", value, ");");
     if (UseForeach() || data_.field.is_map()) {
+      if (UseInitializerList() && !data_.field.is_map()) {
+        // Only the size of initializer lists is known for sure. An empty list
+        // must not make the parent of a sub-field setter present.
+        Write(to, "  if (values.size() != 0) {");
+        Write(to, "    ", data_.data_parent, "mutable_", field_name,
+              "()->Reserve(", data_.data_parent, field_name,
+              "_size() + values.size());");
+        Write(to, "  }");
+      }
       Write(to, "  for (const auto& v : ",
             (data_.field.is_map() ? "key_value_pairs" : "values"), ") {");
       if (UseForeachAdd()) {
@@ -563,14 +735,14 @@ void FieldBuilder::WriteBody(Where to) const {
     const std::string set_value =
         IsMessage(data_.field)
             ? absl::StrCat("*", data_.data_parent, "mutable_", field_name,
-                           "() = ", SetValue(), ";")
-            : absl::StrCat(data_.data_parent, "set_", field_name, "(",
-                           SetValue(), ");");
+                           "() = ", value, ";")
+            : absl::StrCat(data_.data_parent, "set_", field_name, "(", value,
+                           ");");
     Write(to, "  ", set_value);
   }
 }
 
-void FieldBuilder::WriteImplementation(Where to) const {
+void FieldBuilder::WriteImplementation(Where to, bool rvalue) const {
   const std::string function_name =
       to == HEADER ? MethodName()
                    : absl::StrCat(data_.class_name, "::", MethodName());
@@ -578,10 +750,11 @@ void FieldBuilder::WriteImplementation(Where to) const {
   WriteTemplateLine(to);
   const bool is_override = to == HEADER && data_.raw_field_options.override();
   const std::string suffix = is_override ? " override" : "";
-  Write(to, data_.class_name, "& ", function_name, "(", MethodParam(to), ")",
-        suffix, " {");
+  Write(to, data_.class_name, "& ", function_name, "(",
+        MethodParam(to, rvalue), ")", suffix, " {");
   WritePredicate(to);
-  WriteBody(to);
+  WriteInvalidateData(to);
+  WriteBody(to, rvalue);
   Write(to, "  return *this;");
   Write(to, "}");
   Write(to, "");
@@ -606,11 +779,19 @@ void FieldBuilder::WritePredicate(Where to) const {
     // This restriction is in place so that if two fields are being set and the
     // first set operation puts the builder into a non `OkStatus`, then the
     // second field's setting should not override that first error state.
+    // With use_policy the predicate still decides whether the field is set,
+    // but the status is only kept if the policy tracks it.
     Write(to, "const auto status = ", Predicate(), ";");
     Write(to, "if (!status.ok()) {");
+    if (data_.use_policy) {
+      Write(to, "  if constexpr (Policy::kTrackStatus) {");
+    }
     Write(to, "  if (status_.ok()) {");
     Write(to, "    UpdateStatus(status);");
     Write(to, "  }");
+    if (data_.use_policy) {
+      Write(to, "  }");
+    }
   } else {
     // Do not save the result, so there is no reason to include "absl/status.h".
     Write(to, "if (!", Predicate(), ".ok()) {");
@@ -619,6 +800,15 @@ void FieldBuilder::WritePredicate(Where to) const {
   Write(to, "}");
 }
 
+void FieldBuilder::WriteInvalidateData(Where to) const {
+  if (data_.make_view) {
+    Write(to, "  InvalidateData();");
+  } else if (data_.invalidate_data) {
+    // The data changes, so the next access has to validate it again.
+    Write(to, "  data_validated_ = false;");
+  }
+}
+
 void FieldBuilder::WriteError(const std::string& error) const {
   const std::string lines[] = {
       // clang-format off
@@ -693,6 +883,13 @@ void FieldBuilder::AddIncludes() const {
       break;
   }
   AddIncludes(options_);
+  if (UseMoveOverload()) {
+    code_info->AddInclude(UseInlineSetter() ? HEADER : SOURCE, "<utility>");
+  }
+  if (UseSpanOverload()) {
+    AddIncludes(*data_.config.GetTypeInfo("%Span",
+                                          ProtoBuilderTypeInfo::kSpecial));
+  }
   if (options_.add_source_location()) {
     const FieldBuilderOptions* src_loc_options = data_.config.GetTypeInfo(
         "%SourceLocation", ProtoBuilderTypeInfo::kSpecial);
@@ -710,6 +907,10 @@ void FieldBuilder::WriteField() const {
     return;
   }
   AddIncludes();
+  if (UseInlineSetter()) {
+    WriteInlineImplementation();
+    return;
+  }
   if (UseHeader()) {
     if (UseTemplate() || UseForeach()) {
       WriteImplementation(HEADER);
@@ -719,10 +920,81 @@ void FieldBuilder::WriteField() const {
   }
   if (UseSource()) {
     WriteImplementation(SOURCE);
+    if (UseMoveOverload()) {
+      WriteImplementation(SOURCE, /*rvalue=*/true);
+    }
+    if (UseSpanOverload()) {
+      WriteSpanImplementation(SOURCE);
+    }
+  }
+  if (!data_.nested_view.empty() && UseSource()) {
+    WriteViewAccessor(SOURCE);
   }
   if (data_.make_interface) {
     WriteDeclaration(INTERFACE);
   }
 }
 
+bool FieldBuilder::UseWireField() const {
+  if (UseTemplate() || data_.field.is_map() ||
+      data_.field.type() == FieldDescriptor::TYPE_GROUP) {
+    return false;
+  }
+  return data_.raw_field_options.predicate().empty() &&
+         !options_.add_source_location();
+}
+
+std::string FieldBuilder::WireWriteMethod() const {
+  switch (data_.field.type()) {  // clang-format off
+    case FieldDescriptor::TYPE_DOUBLE:   return "WriteDouble";
+    case FieldDescriptor::TYPE_FLOAT:    return "WriteFloat";
+    case FieldDescriptor::TYPE_INT64:    return "WriteInt64";
+    case FieldDescriptor::TYPE_UINT64:   return "WriteUInt64";
+    case FieldDescriptor::TYPE_INT32:    return "WriteInt32";
+    case FieldDescriptor::TYPE_FIXED64:  return "WriteFixed64";
+    case FieldDescriptor::TYPE_FIXED32:  return "WriteFixed32";
+    case FieldDescriptor::TYPE_BOOL:     return "WriteBool";
+    case FieldDescriptor::TYPE_STRING:   return "WriteString";
+    case FieldDescriptor::TYPE_GROUP:    break;
+    case FieldDescriptor::TYPE_MESSAGE:  return "WriteMessage";
+    case FieldDescriptor::TYPE_BYTES:    return "WriteString";
+    case FieldDescriptor::TYPE_UINT32:   return "WriteUInt32";
+    case FieldDescriptor::TYPE_ENUM:     return "WriteEnum";
+    case FieldDescriptor::TYPE_SFIXED32: return "WriteSFixed32";
+    case FieldDescriptor::TYPE_SFIXED64: return "WriteSFixed64";
+    case FieldDescriptor::TYPE_SINT32:   return "WriteSInt32";
+    case FieldDescriptor::TYPE_SINT64:   return "WriteSInt64";
+  }  // clang-format on
+  return "";
+}
+
+void FieldBuilder::WriteWireField() const {
+  if (options_.output() == FieldBuilderOptions::SKIP || !UseWireField()) {
+    return;
+  }
+  AddIncludes();
+  const std::string method = MethodName();
+  const std::string& class_name = data_.class_name;
+  Write(HEADER, class_name, "& ", method, "(", MethodParam(HEADER), ");");
+  Write(SOURCE, "");
+  Write(SOURCE, class_name, "& ", class_name, "::", method, "(",
+        MethodParam(SOURCE), ") {");
+  Write(SOURCE, "  writer_.", WireWriteMethod(), "(", data_.field.number(),
+        ", ", SetValue(), ");");
+  Write(SOURCE, "  return *this;");
+  Write(SOURCE, "}");
+  Write(SOURCE, "");
+  if (data_.first_method && !data_.nested_writer.empty()) {
+    // The nested writer writes into our output and patches its length once it
+    // gets destroyed.
+    Write(HEADER, data_.nested_writer, " ", method, "();");
+    Write(SOURCE, "");
+    Write(SOURCE, data_.nested_writer, " ", class_name, "::", method, "() {");
+    Write(SOURCE, "  return ", data_.nested_writer, "(&writer_, ",
+          data_.field.number(), ");");
+    Write(SOURCE, "}");
+    Write(SOURCE, "");
+  }
+}
+
 }  // namespace proto_builder
@@ -45,6 +45,25 @@ struct FieldData {
   const bool make_interface = false;
   const bool first_method = false;
   const bool use_status = false;
+  // Whether setters have to reset the validation state (see use_validator).
+  const bool invalidate_data = false;
+  // The view class of the field's element type if that has one (see use_view).
+  const std::string nested_view = "";
+  // The validation state that views returned for the field have to reset,
+  // empty if there is none (see use_view and use_validator).
+  const std::string view_validation_state = "";
+  // Whether the setters belong to a view, which resets the validation state
+  // of the builder that owns the data.
+  const bool make_view = false;
+  // Only for WriteWireField: the writer class of the field's message type if
+  // that has one (see use_writer).
+  const std::string nested_writer = "";
+  // Whether the builder is a class template (see use_policy), which needs all
+  // methods to be defined in the header.
+  const bool use_policy = false;
+  // Whether trivial setters are defined in the header (see
+  // inline_trivial_setters).
+  const bool inline_trivial_setters = false;
 
   std::string DebugString() const {
     return absl::StrJoin(
@@ -65,6 +84,17 @@ class FieldBuilder {
   // Writes the code for this field using Write().
   void WriteField() const;
 
+  // Same as `WriteField` of a FieldBuilder for `data`. Only for tests and
+  // benchmarks that write single fields without a MessageBuilder.
+  static void WriteFieldForTesting(const FieldData& data) {
+    FieldBuilder(data).WriteField();
+  }
+
+  // Writes the setter of the streaming writer (see use_writer), which encodes
+  // the value directly into `writer_`. Fields that cannot be written without
+  // the message data (predicates, maps, templates, ...) are skipped.
+  void WriteWireField() const;
+
  private:
   explicit FieldBuilder(const FieldData& data);
 
@@ -76,6 +106,24 @@ class FieldBuilder {
   bool UseSource() const;
   bool UseMapInsert() const;
 
+  // Whether to generate an additional setter that takes an rvalue reference
+  // and moves it into the field. This is only done for string, bytes and
+  // message typed values that are passed as 'const T&' without conversion.
+  bool UseMoveOverload() const;
+
+  // Whether to generate an additional 'AddX(absl::Span<const T> values)' that
+  // appends all values at once. This is only done for repeated numeric and
+  // bool fields without conversion or predicate.
+  bool UseSpanOverload() const;
+
+  // Whether the setters only store the value: no conversion, predicate, source
+  // location or source include.
+  bool IsTrivialSetter() const;
+
+  // Whether the setters of a HEADER and SOURCE field are defined in the class
+  // instead (see use_policy and inline_trivial_setters).
+  bool UseInlineSetter() const;
+
   // Returns name_parent appended with name if not empty or field_.name()
   // converted into a CamelCase name.
   std::string CamelCaseFieldName(const std::string& name = "") const;
@@ -103,7 +151,9 @@ class FieldBuilder {
   std::string ParameterType(bool decorate) const;
 
   std::string MethodName() const;
-  std::string MethodParam(Where to) const;
+  // Returns the parameter list. If 'rvalue' is true, then the value parameter
+  // is taken as 'T&&' (see UseMoveOverload).
+  std::string MethodParam(Where to, bool rvalue = false) const;
 
   // The expression used in set and assignments.
   std::string SetValue() const;
@@ -114,12 +164,25 @@ class FieldBuilder {
 
   bool UseSetFromBuilder() const;
 
+  bool UseWireField() const;
+  // The ::proto_builder::oss::WireWriter method used for the field type.
+  std::string WireWriteMethod() const;
+
   void WriteTemplateLine(Where to) const;
   void WriteDeclaration(Where to) const;
   void WriteSetFromBuilder() const;
-  void WriteBody(Where to) const;
-  void WriteImplementation(Where to) const;
+  void WriteSpanImplementation(Where to) const;
+  // Writes `MutableX()`, `AddXBuilder()` or `InsertXBuilder(key)` which return
+  // a view of the (added) message in place. For the HEADER only the in class
+  // definition is written.
+  void WriteViewAccessor(Where to) const;
+  // Writes all methods for the field as in class definitions (see
+  // UseInlineSetter).
+  void WriteInlineImplementation() const;
+  void WriteBody(Where to, bool rvalue) const;
+  void WriteImplementation(Where to, bool rvalue = false) const;
   void WritePredicate(Where to) const;
+  void WriteInvalidateData(Where to) const;
 
   // Writes an '#error...<error>' line. The error message should be the plain
   // error message without any additional field info, which will be appended
@@ -38,8 +38,10 @@
 namespace proto_builder {
 namespace {
 constexpr char kIncludeString[] = "<string>";
+constexpr char kIncludeUtility[] = "<utility>";
 constexpr char kIncludeStringView[] = "absl/strings/string_view.h";
 constexpr char kIncludeDuration[] = "absl/time/time.h";
+constexpr char kIncludeSpan[] = "absl/types/span.h";
 constexpr char kIncludeTestMessage[] =
     "\"proto_builder/tests/test_message.pb.h\""
     "  // IWYU pragma: export";
@@ -102,11 +104,14 @@ class FieldBuilderTest : public ::testing::Test {
   }
 
   const FieldBuilder Builder(const google::protobuf::FieldDescriptor& field_descriptor,
-                             const FieldBuilderOptions& options) {
+                             const FieldBuilderOptions& options,
+                             bool first_method = false) {
     auto field_options = GetFieldBuilderOptionsOrDefault(field_descriptor);
     field_options.MergeFrom(options);
     return FieldBuilder({global_config_, &writer_, field_options,
-                         field_descriptor, "my_type", "data_.", "my_parent"});
+                         field_descriptor, "my_type", "data_.", "my_parent",
+                         /*use_get_raw_data=*/false, /*make_interface=*/false,
+                         first_method});
   }
 
   template <class Msg>
@@ -115,6 +120,23 @@ class FieldBuilderTest : public ::testing::Test {
     return Builder(FindFieldByName<Msg>(field_name), options);
   }
 
+  // Like Builder, but for a message with inline_trivial_setters.
+  template <class Msg>
+  const FieldBuilder InlineBuilder(absl::string_view field_name,
+                                   absl::string_view options) {
+    const FieldDescriptor& field_descriptor = FindFieldByName<Msg>(field_name);
+    auto field_options = GetFieldBuilderOptionsOrDefault(field_descriptor);
+    field_options.MergeFrom(ParseTextProtoOrDie(options));
+    return FieldBuilder({.config = global_config_,
+                         .writer = &writer_,
+                         .raw_field_options = field_options,
+                         .field = field_descriptor,
+                         .class_name = "my_type",
+                         .data_parent = "data_.",
+                         .name_parent = "my_parent",
+                         .inline_trivial_setters = true});
+  }
+
   template <class Msg>
   void WriteField(absl::string_view field_name, absl::string_view options) {
     Builder<Msg>(field_name, ParseTextProtoOrDie(options)).WriteField();
@@ -227,6 +249,8 @@ void FieldBuilderTest::GetTypeTest() {
     EXPECT_THAT(builder.ParameterType(true),
                 t.decorate ? absl::StrCat("const ", t.type, "&") : t.type)
         << "Of all possible field types only messages get decorated.";
+    // Decorated types can be moved from.
+    EXPECT_THAT(builder.UseMoveOverload(), t.decorate);
     // Check incldues.
     if (t.include.empty()) {
       EXPECT_CALL(writer_, AddInclude(_, _)).Times(0);
@@ -234,6 +258,9 @@ void FieldBuilderTest::GetTypeTest() {
       EXPECT_CALL(writer_, AddInclude(HEADER, t.include)).Times(1);
       EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
     }
+    if (t.decorate) {
+      EXPECT_CALL(writer_, AddInclude(SOURCE, kIncludeUtility)).Times(1);
+    }
     builder.AddIncludes();
     Mock::VerifyAndClearExpectations(&writer_);
   }
@@ -497,6 +524,27 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_Conversion) {
   WriteField<TestMessage>("one", "type: '@ToInt64Seconds'");
 }
 
+TEST_F(FieldBuilderTest, WriteFieldBuilder_InlineTrivialSetter) {
+  Expect<HEADER>(  // clang-format off
+      "my_type& Setmy_parentOne(int32_t value) {",
+      "  data_.set_one(value);",
+      "  return *this;",
+      "}");  // clang-format on
+  ExpectNo<SOURCE>();
+  InlineBuilder<TestMessage>("one", "").WriteField();
+}
+
+TEST_F(FieldBuilderTest, WriteFieldBuilder_InlineTrivialSetter_Conversion) {
+  EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeDuration)).Times(AtLeast(1));
+  Expect<HEADER>("my_type& Setmy_parentOne(absl::Duration value);");
+  Expect<SOURCE>(  // clang-format off
+      "my_type& my_type::Setmy_parentOne(absl::Duration value) {",
+      "  data_.set_one(absl::ToInt64Seconds(value));",
+      "  return *this;",
+      "}");  // clang-format on
+  InlineBuilder<TestMessage>("one", "type: '@ToInt64Seconds'").WriteField();
+}
+
 TEST_F(FieldBuilderTest, WriteFieldBuilder_Repeated) {
   struct {
     FieldBuilderOptions::OutputMode output;
@@ -543,6 +591,24 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_RepeatedReservedKeyword) {
   }
 }
 
+TEST_F(FieldBuilderTest, WriteFieldBuilder_Repeated_Span) {
+  EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeSpan)).Times(AtLeast(1));
+  Expect<HEADER>(  // clang-format off
+      "my_type& Addmy_parentTwo(int32_t value);",
+      "my_type& Addmy_parentTwo(absl::Span<const int32_t> values);");
+  Expect<SOURCE>(
+      "my_type& my_type::Addmy_parentTwo(int32_t value) {",
+      "  data_.add_two(value);",
+      "my_type& my_type::Addmy_parentTwo(absl::Span<const int32_t> values) {",
+      "  data_.mutable_two()->Add(values.begin(), values.end());");
+  Expect<SOURCE>(2,
+      "  return *this;",
+      "}");  // clang-format on
+  Builder(FindFieldByName<TestMessage>("two"), FieldBuilderOptions(),
+          /*first_method=*/true)
+      .WriteField();
+}
+
 TEST_F(FieldBuilderTest, WriteFieldBuilder_Repeated_Conversion) {
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeDuration)).Times(AtLeast(1));
   EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
@@ -647,6 +713,7 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_Repeated_InitializerList) {
   Expect<HEADER>(  // clang-format off
       "template <class Item>",
       "my_type& Addmy_parentTwo(std::initializer_list<Item> values) {",
+      "  data_.mutable_two()->Reserve(data_.two_size() + values.size());",
       "  for (const auto& v : values) {",
       "    Addmy_parentTwo(v);",
       "  }",
@@ -663,6 +730,7 @@ TEST_F(FieldBuilderTest,
   Expect<HEADER>(  // clang-format off
       "template <class Item>",
       "my_type& Addmy_parentTwo(std::initializer_list<Item> values) {",
+      "  data_.mutable_two()->Reserve(data_.two_size() + values.size());",
       "  for (const auto& v : values) {",
       "    Addmy_parentTwo(absl::ToInt64Seconds(v));",
       "  }",
@@ -675,12 +743,16 @@ TEST_F(FieldBuilderTest,
 
 TEST_F(FieldBuilderTest, WriteFieldBuilder_NonRepeatedMessage) {
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeTestMessage)).Times(1);
-  EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
+  EXPECT_CALL(writer_, AddInclude(SOURCE, kIncludeUtility)).Times(1);
   Expect<HEADER>(  // clang-format off
-      "my_type& Setmy_parentThree(const ::proto_builder::TestMessage::Sub& value);");  // NOLINT
+      "my_type& Setmy_parentThree(const ::proto_builder::TestMessage::Sub& value);",  // NOLINT
+      "my_type& Setmy_parentThree(::proto_builder::TestMessage::Sub&& value);");  // NOLINT
   Expect<SOURCE>(
       "my_type& my_type::Setmy_parentThree(const ::proto_builder::TestMessage::Sub& value) {",  // NOLINT
       "  *data_.mutable_three() = value;",
+      "my_type& my_type::Setmy_parentThree(::proto_builder::TestMessage::Sub&& value) {",  // NOLINT
+      "  *data_.mutable_three() = std::move(value);");
+  Expect<SOURCE>(2,
       "  return *this;",
       "}");  // clang-format on
   WriteField<TestMessage>("three", "");
@@ -688,12 +760,16 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_NonRepeatedMessage) {
 
 TEST_F(FieldBuilderTest, WriteFieldBuilder_StringWithAnnotationString) {
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeString)).Times(AtLeast(1));
-  EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
+  EXPECT_CALL(writer_, AddInclude(SOURCE, kIncludeUtility)).Times(1);
   Expect<HEADER>(  // clang-format off
-      "my_type& Setmy_parentString22(const std::string& value);");  // NOLINT
+      "my_type& Setmy_parentString22(const std::string& value);",  // NOLINT
+      "my_type& Setmy_parentString22(std::string&& value);");  // NOLINT
   Expect<SOURCE>(
       "my_type& my_type::Setmy_parentString22(const std::string& value) {",  // NOLINT
       "  data_.set_string22(value);",
+      "my_type& my_type::Setmy_parentString22(std::string&& value) {",  // NOLINT
+      "  data_.set_string22(std::move(value));");
+  Expect<SOURCE>(2,
       "  return *this;",
       "}");  // clang-format on
   WriteField<TestMessage>("string22", "");
@@ -715,12 +791,16 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_StringWithAnnotationStringView) {
 
 TEST_F(FieldBuilderTest, WriteFieldBuilder_BytesWithAnnotationString) {
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeString)).Times(AtLeast(1));
-  EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
+  EXPECT_CALL(writer_, AddInclude(SOURCE, kIncludeUtility)).Times(1);
   Expect<HEADER>(  // clang-format off
-      "my_type& Setmy_parentBytes26(const std::string& value);");  // NOLINT
+      "my_type& Setmy_parentBytes26(const std::string& value);",  // NOLINT
+      "my_type& Setmy_parentBytes26(std::string&& value);");  // NOLINT
   Expect<SOURCE>(
       "my_type& my_type::Setmy_parentBytes26(const std::string& value) {",  // NOLINT
       "  data_.set_bytes26(value);",
+      "my_type& my_type::Setmy_parentBytes26(std::string&& value) {",  // NOLINT
+      "  data_.set_bytes26(std::move(value));");
+  Expect<SOURCE>(2,
       "  return *this;",
       "}");  // clang-format on
   WriteField<TestMessage>("bytes26", "");
@@ -730,12 +810,16 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_SourceLocation_Single) {
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeString)).Times(AtLeast(1));
   EXPECT_CALL(writer_, AddInclude(HEADER, kIncludeSourceLocation))
       .Times(AtLeast(1));
-  EXPECT_CALL(writer_, AddInclude(SOURCE, _)).Times(0);
+  EXPECT_CALL(writer_, AddInclude(SOURCE, kIncludeUtility)).Times(1);
   Expect<HEADER>(  // clang-format off
-      "my_type& Addmy_parentTarget(const std::string& value, proto_builder::oss::SourceLocation source_location = proto_builder::oss::SourceLocation::current());");  // NOLINT
+      "my_type& Addmy_parentTarget(const std::string& value, proto_builder::oss::SourceLocation source_location = proto_builder::oss::SourceLocation::current());",  // NOLINT
+      "my_type& Addmy_parentTarget(std::string&& value, proto_builder::oss::SourceLocation source_location = proto_builder::oss::SourceLocation::current());");  // NOLINT
   Expect<SOURCE>(
       "my_type& my_type::Addmy_parentTarget(const std::string& value, proto_builder::oss::SourceLocation source_location) {",  // NOLINT
       "  data_.add_target(value);",
+      "my_type& my_type::Addmy_parentTarget(std::string&& value, proto_builder::oss::SourceLocation source_location) {",  // NOLINT
+      "  data_.add_target(std::move(value));");
+  Expect<SOURCE>(2,
       "  return *this;",
       "}");  // clang-format on
   WriteField<tests::SourceLocation>(
@@ -753,6 +837,7 @@ TEST_F(FieldBuilderTest, WriteFieldBuilder_SourceLocation_InitializerList) {
   Expect<HEADER>(  // clang-format off
       "template <class Item>",
       "my_type& Addmy_parentTargets(std::initializer_list<Item> values, proto_builder::oss::SourceLocation source_location = proto_builder::oss::SourceLocation::current()) {",  // NOLINT
+      "  data_.mutable_target()->Reserve(data_.target_size() + values.size());",
       "  for (const auto& v : values) {",
       "    Addmy_parentTarget(v, source_location);",
       "  }",
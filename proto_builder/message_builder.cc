@@ -18,22 +18,21 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/compiler/cpp/cpp_helpers.h"
 #include "proto_builder/field_builder.h"
 #include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/trace.h"
 #include "proto_builder/proto_builder_config.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
 
 namespace proto_builder {
 
-// Max recursion depth for sub-field setters.  We never expand more than five
-// messages deep when generating setters.  Past this depth, we feel the setters
-// start to become particularly unwieldy.
-static const int kMaxSubFieldSetterDepth = 5;
-
 std::pair<std::string, std::string> GetPackageAndClassName(
     const ::google::protobuf::Descriptor* descriptor) {
   std::string name = PBCC_DIE_IF_NULL(descriptor)->name();
@@ -59,18 +58,44 @@ MessageBuilder::MessageBuilder(Options options)
         if (!root_options.has_use_validator()) {
           root_options.set_use_validator(options.use_validator);
         }
+        if (!root_options.has_inline_trivial_setters()) {
+          root_options.set_inline_trivial_setters(
+              options.inline_trivial_setters);
+        }
+        if (root_options.use_policy()) {
+          // Policies select the checks at compile time, so the status always
+          // exists. The class template does not support arenas.
+          root_options.set_use_status(true);
+          root_options.set_use_arena(false);
+        }
+        if (root_options.use_arena() && !root_options.has_root_data()) {
+          root_options.set_root_data("data_->");
+        }
+        if (options_.make_view) {
+          // Views only point to the data and have no status of their own.
+          root_options.set_root_data("data_->");
+          root_options.set_use_build(false);
+          root_options.set_use_status(false);
+          root_options.set_use_validator(false);
+          root_options.set_use_policy(false);
+        }
         return root_options;
       }()),
-      class_name_(!root_options_.class_name().empty()
-                      ? root_options_.class_name()
-                      : absl::StrCat(
-                            GetPackageAndClassName(&options_.descriptor).second,
-                            "Builder")) {
+      class_name_(absl::StrCat(
+          !root_options_.class_name().empty()
+              ? root_options_.class_name()
+              : absl::StrCat(
+                    GetPackageAndClassName(&options_.descriptor).second,
+                    "Builder"),
+          options_.make_view ? "View" : "")),
+      writer_name_(
+          absl::StrCat(absl::StripSuffix(class_name_, "Builder"), "Writer")) {
   CHECK_GT(class_name_.size(), 0);
 }
 
-void MessageBuilder::WriteBuilder() {
+void MessageBuilder::WriteBuilder(const ClassNames& view_names) {
   messages_in_subfield_setter_stack_.clear();
+  view_names_ = &view_names;
   writer_->CodeInfo()->AddInclude(HEADER, root_descriptor_);
   WriteMessage(root_descriptor_, root_options().root_data(),
                root_options().root_name(), /* depth= */ 0);
@@ -78,6 +103,71 @@ void MessageBuilder::WriteBuilder() {
   writer_->Write(HEADER, "");
   writer_->Write(SOURCE, "");
   writer_->Write(INTERFACE, "");
+  view_names_ = nullptr;
+}
+
+void MessageBuilder::WriteWriter(BuilderWriter* writer,
+                                 const ClassNames& writer_names) {
+  const std::unique_ptr<BuilderWriter> wire_writer =
+      OwnWrappedWriter<NoDoubleEmptyLineWriter>::New(
+          std::make_unique<IndentWriter>(writer, "  "));
+  // Writing in field number order produces the canonical serialization.
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(root_descriptor_.field_count());
+  for (int i = 0; i < root_descriptor_.field_count(); ++i) {
+    fields.push_back(PBCC_DIE_IF_NULL(root_descriptor_.field(i)));
+  }
+  absl::c_sort(fields, [](const FieldDescriptor* a, const FieldDescriptor* b) {
+    return a->number() < b->number();
+  });
+  for (const FieldDescriptor* field_descriptor : fields) {
+    const auto it = field_descriptor->message_type() != nullptr
+                        ? writer_names.find(field_descriptor->message_type())
+                        : writer_names.end();
+    const std::string nested_writer =
+        it != writer_names.end() ? it->second : "";
+    const auto write = [&](const FieldBuilderOptions& options,
+                           bool first_method) {
+      const FieldData data{
+          .config = options_.config,
+          .writer = wire_writer.get(),
+          .raw_field_options = options,
+          .field = *field_descriptor,
+          .class_name = writer_name_,
+          .first_method = first_method,
+          .nested_writer = nested_writer,
+      };
+      FieldBuilder(data).WriteWireField();
+    };
+    const ::google::protobuf::FieldOptions& field_options = field_descriptor->options();
+    const int size = field_options.ExtensionSize(field /* proto option */);
+    if (size == 0) {
+      write({}, true);
+    }
+    for (int f = 0; f < size; ++f) {
+      write(options_.config.MergeFieldBuilderOptions(
+                field_options.GetExtension(field, f)),
+            !f);
+    }
+  }
+  wire_writer->Write(HEADER, "");
+  wire_writer->Write(SOURCE, "");
+}
+
+std::string MessageBuilder::NestedView(
+    const FieldDescriptor& field_descriptor) const {
+  if (view_names_ == nullptr) {
+    return "";
+  }
+  const ::google::protobuf::Descriptor* type = field_descriptor.message_type();
+  if (type != nullptr && field_descriptor.is_map()) {
+    type = PBCC_DIE_IF_NULL(type->field(1))->message_type();
+  }
+  if (type == nullptr) {
+    return "";
+  }
+  const auto it = view_names_->find(type);
+  return it != view_names_->end() ? it->second : "";
 }
 
 FieldData MessageBuilder::MakeFieldData(const FieldBuilderOptions& options,
@@ -91,18 +181,38 @@ FieldData MessageBuilder::MakeFieldData(const FieldBuilderOptions& options,
           ? root_options_.use_build() || root_options_.use_status() ||
                 root_options_.use_validator()
           : options_.use_validator;
+  FieldBuilderOptions field_options = options;
+  if (options_.make_view) {
+    // Views have no base class to override.
+    field_options.clear_override();
+  }
   return {
       .config = options_.config,
       .writer = writer_.get(),
-      .raw_field_options = options,
+      .raw_field_options = field_options,
       .field = field_descriptor,
-      .class_name = class_name_,
+      .class_name = root_options_.use_policy()
+                        ? absl::StrCat(class_name_, "T")
+                        : class_name_,
       .data_parent = data_parent,
       .name_parent = name_parent,
       .use_get_raw_data = use_get_raw_data,
-      .make_interface = options_.make_interface,
+      .make_interface = options_.make_interface && !options_.make_view &&
+                        !root_options_.use_policy(),
       .first_method = first_method,
       .use_status = root_options_.use_status(),
+      .invalidate_data = root_options_.use_validator() &&
+                         !root_options_.incremental_validation(),
+      .nested_view = first_method ? NestedView(field_descriptor) : "",
+      // Views write into the data of a builder without going through its
+      // setters, so they reset the builder's validation state themselves.
+      .view_validation_state = options_.make_view ? "data_validated_"
+                               : root_options_.use_validator()
+                                   ? "&data_validated_"
+                                   : "",
+      .make_view = options_.make_view,
+      .use_policy = root_options_.use_policy(),
+      .inline_trivial_setters = root_options_.inline_trivial_setters(),
   };
 }
 
@@ -157,13 +267,19 @@ bool MessageBuilder::WriteField(const FieldDescriptor& field_descriptor,
 void MessageBuilder::WriteMessage(const ::google::protobuf::Descriptor& descriptor,
                                   const std::string& data_parent,
                                   const std::string& name_parent, int depth) {
+  oss::TraceScope trace("WriteMessage");
+  trace.AddArg("message", descriptor.full_name());
+  trace.AddArg("depth", depth);
   const std::string log_info =
       absl::StrCat("Message: ", descriptor.full_name(), "[", depth, "]");
   if (depth > kMaxSubFieldSetterDepth) {
     LOG(ERROR) << log_info << " Max sub-field setter depth reached.";
     return;
   }
-  if (!messages_in_subfield_setter_stack_.insert(&descriptor).second) {
+  const bool track_message =
+      options_.graph == nullptr || options_.graph->IsRecursive(descriptor);
+  if (track_message &&
+      !messages_in_subfield_setter_stack_.insert(&descriptor).second) {
     LOG(INFO) << log_info << " Already used in sub-field setter stack.";
     return;
   }
@@ -208,7 +324,9 @@ void MessageBuilder::WriteMessage(const ::google::protobuf::Descriptor& descript
       writer_->CodeInfo()->AddInclude(HEADER, **map_value_descriptor);
     }
   }
-  messages_in_subfield_setter_stack_.erase(&descriptor);
+  if (track_message) {
+    messages_in_subfield_setter_stack_.erase(&descriptor);
+  }
 }
 
 }  // namespace proto_builder
@@ -21,9 +21,11 @@
 #include <string>
 #include <tuple>
 
+#include "proto_builder/descriptor_graph.h"
 #include "proto_builder/field_builder.h"
 #include "proto_builder/proto_builder.pb.h"
 #include "google/protobuf/descriptor.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 
 namespace proto_builder {
@@ -34,10 +36,19 @@ using ::google::protobuf::FieldDescriptor;
 std::pair<std::string, std::string> GetPackageAndClassName(
     const ::google::protobuf::Descriptor* descriptor);
 
+// Maps message types to the name of a generated class for them, e.g. their
+// writer (see use_writer) or view (see use_view).
+using ClassNames = absl::flat_hash_map<const ::google::protobuf::Descriptor*, std::string>;
+
 // Class to write code for a single protocol message type.
 // READ: https://google.github.io/cpp-proto-builder#MessageBuilder
 class MessageBuilder {
  public:
+  // Max recursion depth for sub-field setters.  We never expand more than five
+  // messages deep when generating setters.  Past this depth, we feel the
+  // setters start to become particularly unwieldy.
+  static constexpr int kMaxSubFieldSetterDepth = 5;
+
   struct Options {
     const ProtoBuilderConfigManager& config;
     BuilderWriter* writer;         // The writer will not be owned
@@ -45,17 +56,37 @@ class MessageBuilder {
     size_t max_field_depth;        // Maximum message depth (1 = this only)
     bool use_validator = false;    // Whether to generate Validator code
     bool make_interface = false;   // Whether to make an Interface
+    // Default for the inline_trivial_setters message option.
+    bool inline_trivial_setters = false;
+    // Graph containing `descriptor`, used to restrict the cycle checks of
+    // sub-field setters to recursive messages. If nullptr, all are checked.
+    const DescriptorGraph* graph = nullptr;
+    // Whether to write the setters of the non-owning view (see use_view)
+    // rather than those of the builder.
+    bool make_view = false;
   };
 
   explicit MessageBuilder(Options options);
 
-  void WriteBuilder();
+  // Message and map fields whose type is in `view_names` get an additional
+  // method that returns a view of the (added) message in place.
+  void WriteBuilder(const ClassNames& view_names = {});
+
+  // Writes the setters of the streaming writer (see use_writer) into
+  // `writer`. Message fields whose type is in `writer_names` additionally get
+  // a method that returns a nested writer of that name.
+  void WriteWriter(BuilderWriter* writer, const ClassNames& writer_names);
 
   const ::google::protobuf::Descriptor& root_descriptor() const { return root_descriptor_; }
   const MessageBuilderOptions& root_options() const { return root_options_; }
   const std::string& class_name() const { return class_name_; }
+  const std::string& writer_name() const { return writer_name_; }
 
  private:
+  // Returns the view class for (the elements of) `field_descriptor` if it is a
+  // message or map field whose message type has a view, otherwise "".
+  std::string NestedView(const FieldDescriptor& field_descriptor) const;
+
   FieldData MakeFieldData(const FieldBuilderOptions& options,
                           const FieldDescriptor& field_descriptor,
                           const std::string& data_parent,
@@ -73,14 +104,18 @@ class MessageBuilder {
                     const std::string& name_parent, int depth);
 
   // Tracks the set of messages that have been used in a sub-field setter in
-  // the current WriteMessage(...) recursive call stack.
+  // the current WriteMessage(...) recursive call stack. Only recursive
+  // messages get tracked, others cannot appear twice in the stack.
   absl::flat_hash_set<const ::google::protobuf::Descriptor*> messages_in_subfield_setter_stack_;
+  // Only valid during WriteBuilder.
+  const ClassNames* view_names_ = nullptr;
 
   const Options options_;
   const std::unique_ptr<BuilderWriter> writer_;
   const ::google::protobuf::Descriptor& root_descriptor_;
   const MessageBuilderOptions root_options_;
   const std::string class_name_;
+  const std::string writer_name_;
 };
 
 }  // namespace proto_builder
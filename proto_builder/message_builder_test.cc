@@ -108,8 +108,10 @@ TEST_F(MessageBuilderTest, Includes) {
           "\"proto_builder/tests/test_message.pb.h\""
           "  // IWYU pragma: export",
           "\"absl/strings/string_view.h\"",  // "s included
+          "\"absl/types/span.h\"",
           "<string>"));
-  EXPECT_THAT(writer.CodeInfo()->GetIncludes(SOURCE), IsEmpty());
+  EXPECT_THAT(writer.CodeInfo()->GetIncludes(SOURCE),
+              UnorderedElementsAre("<utility>"));
 }
 
 class MessageBuilderFileTest : public ::testing::TestWithParam<TestCase> {
@@ -0,0 +1,57 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_BUILDER_POLICY_H_
+#define PROTO_BUILDER_OSS_BUILDER_POLICY_H_
+
+namespace proto_builder::oss {
+
+// Policies for builders generated with `use_policy`, which are class templates
+// `FooBuilderT<Policy>`. Each flag selects at compile time whether the checks
+// are generated, so disabled ones cost nothing. Custom policies need to provide
+// the same members.
+//
+// Example:
+//
+//   // Tests and most code keep all checks: FooBuilder = FooBuilderT<>.
+//   FooBuilder builder;
+//
+//   // A hot path that only feeds valid values skips them.
+//   FooBuilderT<UncheckedPolicy> fast;
+
+// Keeps all checks, the default policy.
+struct CheckedPolicy {
+  // Whether the builder tracks a status. Without it, predicates still decide
+  // whether a field is set but their errors are dropped, `UpdateStatus` does
+  // nothing and `ok()` is always true.
+  static constexpr bool kTrackStatus = true;
+  // Whether the data gets validated (see `use_validator`), which requires
+  // `kTrackStatus`.
+  static constexpr bool kValidate = true;
+  // Whether errors get the source location of the builder attached.
+  static constexpr bool kSourceLocation = true;
+};
+
+// Removes all checks.
+struct UncheckedPolicy {
+  static constexpr bool kTrackStatus = false;
+  static constexpr bool kValidate = false;
+  static constexpr bool kSourceLocation = false;
+};
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_BUILDER_POLICY_H_
@@ -0,0 +1,103 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_BUILDER_POOL_H_
+#define PROTO_BUILDER_OSS_BUILDER_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace proto_builder::oss {
+
+// Recycles builders of type `B` through per thread free lists, so that hot
+// loops do not reallocate the whole message tree on every iteration:
+//
+//   for (...) {
+//     auto builder = BuilderPool<FooBuilder>::Acquire();
+//     builder->SetName(name).AddValues(value);
+//     Send(*builder);
+//   }  // The builder gets Reset() and returned to the pool.
+//
+// Returned builders are `Reset()`, which keeps the memory their data already
+// allocated. At most `kMaxFree` builders are kept per thread. `B` must be
+// default constructible, so builders that need an arena or rely on their
+// construction source location should not be pooled.
+template <typename B, std::size_t kMaxFree = 8>
+class BuilderPool final {
+ public:
+  // Owns a builder while it is in use and returns it to the pool of the
+  // current thread on destruction.
+  class Lease final {
+   public:
+    Lease(Lease&& other) = default;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    Lease& operator=(Lease&&) = delete;
+
+    ~Lease() {
+      if (builder_) {
+        BuilderPool::Release(std::move(builder_));
+      }
+    }
+
+    B& operator*() const { return *builder_; }
+    B* operator->() const { return builder_.get(); }
+    B* get() const { return builder_.get(); }
+
+   private:
+    friend class BuilderPool;
+
+    explicit Lease(std::unique_ptr<B> builder) : builder_(std::move(builder)) {}
+
+    std::unique_ptr<B> builder_;
+  };
+
+  BuilderPool() = delete;
+
+  // Returns a reset builder, creating a new one only if the pool is empty.
+  static Lease Acquire() {
+    auto& free_list = FreeList();
+    if (free_list.empty()) {
+      return Lease(std::make_unique<B>());
+    }
+    std::unique_ptr<B> builder = std::move(free_list.back());
+    free_list.pop_back();
+    return Lease(std::move(builder));
+  }
+
+  // Number of builders that are ready for reuse on the current thread.
+  static std::size_t FreeCount() { return FreeList().size(); }
+
+ private:
+  static void Release(std::unique_ptr<B> builder) {
+    builder->Reset();
+    auto& free_list = FreeList();
+    if (free_list.size() < kMaxFree) {
+      free_list.push_back(std::move(builder));
+    }
+  }
+
+  static std::vector<std::unique_ptr<B>>& FreeList() {
+    thread_local std::vector<std::unique_ptr<B>> free_list;
+    return free_list;
+  }
+};
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_BUILDER_POOL_H_
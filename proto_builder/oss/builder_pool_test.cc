@@ -0,0 +1,107 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/builder_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "proto_builder/oss/tests/simple_message.pb.h"
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+
+namespace proto_builder::oss {
+namespace {
+
+using ::testing::oss::EqualsProto;
+
+// Minimal stand-in for a generated builder.
+class SimpleMessageBuilder {
+ public:
+  SimpleMessageBuilder& SetOne(int value) {
+    data_.set_one(value);
+    return *this;
+  }
+
+  SimpleMessageBuilder& AddTwo(int value) {
+    data_.add_two(value);
+    return *this;
+  }
+
+  SimpleMessageBuilder& Reset() {
+    data_.Clear();
+    return *this;
+  }
+
+  const SimpleMessage& data() const { return data_; }
+
+ private:
+  SimpleMessage data_;
+};
+
+using Pool = BuilderPool<SimpleMessageBuilder, 2>;
+
+TEST(BuilderPoolTest, ReusesResetBuilders) {
+  const SimpleMessageBuilder* first = nullptr;
+  const int* two_data = nullptr;
+  {
+    auto builder = Pool::Acquire();
+    builder->SetOne(1).AddTwo(2).AddTwo(3);
+    EXPECT_THAT(builder->data(), EqualsProto("one: 1 two: 2 two: 3"));
+    first = builder.get();
+    two_data = builder->data().two().data();
+  }
+  EXPECT_EQ(Pool::FreeCount(), 1);
+  auto builder = Pool::Acquire();
+  EXPECT_EQ(Pool::FreeCount(), 0);
+  EXPECT_EQ(builder.get(), first);
+  EXPECT_THAT(builder->data(), EqualsProto(""));
+  // The repeated field keeps its capacity.
+  builder->AddTwo(4);
+  EXPECT_EQ(builder->data().two().data(), two_data);
+}
+
+TEST(BuilderPoolTest, KeepsAtMostMaxFree) {
+  {
+    auto a = Pool::Acquire();
+    auto b = Pool::Acquire();
+    auto c = Pool::Acquire();
+  }
+  EXPECT_EQ(Pool::FreeCount(), 2);
+}
+
+TEST(BuilderPoolTest, MovedLeaseReturnsOnce) {
+  const std::size_t free_count = Pool::FreeCount();
+  {
+    auto builder = Pool::Acquire();
+    auto moved = std::move(builder);
+    moved->SetOne(5);
+  }
+  EXPECT_EQ(Pool::FreeCount(), std::max<std::size_t>(free_count, 1));
+}
+
+TEST(BuilderPoolTest, FreeListsArePerThread) {
+  { auto builder = Pool::Acquire(); }
+  ASSERT_GT(Pool::FreeCount(), 0);
+  std::size_t other_free_count = 1;
+  std::thread([&] { other_free_count = Pool::FreeCount(); }).join();
+  EXPECT_EQ(other_free_count, 0);
+}
+
+}  // namespace
+}  // namespace proto_builder::oss
@@ -23,6 +23,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace file {
 namespace oss {  // namespace to avoid conflict with libraries using the file
@@ -33,7 +34,11 @@ std::string JoinPathSimplify(absl::string_view path);  // See JoinPath.
 }  // namespace internal
 
 struct Options {
-  // empty options to conforms with internal API
+  // If set, then SetContents compares the new content with the existing file
+  // and leaves it untouched (including its mtime) if they are identical.
+  // Otherwise the content is written to a temporary file that atomically
+  // replaces the target.
+  bool write_if_changed = false;
 };
 
 Options Defaults();
@@ -46,10 +51,16 @@ Options Defaults();
 //
 // Typical return codes (not guaranteed exhaustive):
 //  * OK
-//  * UNKNOWN (a Write, a Close or Open error occurred)
+//  * UNKNOWN (a Write, a Close, Open or Rename error occurred)
 absl::Status SetContents(absl::string_view file_name, absl::string_view content,
                          const Options& options = Defaults());
 
+// Same as above but writes the concatenation of all `pieces` straight to the
+// file. This avoids joining large, already chunked content in memory first.
+absl::Status SetContents(absl::string_view file_name,
+                         absl::Span<const absl::string_view> pieces,
+                         const Options& options = Defaults());
+
 // Answers the question, "Does the named file exist, and is it readable?"
 //
 // Typical return codes (not guaranteed exhaustive):
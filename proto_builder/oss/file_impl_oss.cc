@@ -16,8 +16,13 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <filesystem>
 #include <string>
 
@@ -29,28 +34,39 @@
 namespace file {
 namespace oss {
 
-absl::Status SetContents(absl::string_view file_name, absl::string_view content,
-                         const Options& options) {
-  // Use POSIX C APIs instead of C++ iostreams to avoid exceptions.
-  int fd = open(std::string(file_name).c_str(),
-                O_WRONLY | O_CREAT | O_CLOEXEC | O_TRUNC, 0664);
-  if (fd == -1) {
-    return absl::UnknownError(
-        absl::StrFormat("Unable to open file: '%s'", file_name));
-  }
+namespace {
 
-  int64_t written = 0;
-  while (written < static_cast<int64_t>(content.size())) {
+// Writes all of `content` to `fd`, retrying on short writes.
+bool WriteAll(int fd, absl::string_view content) {
+  size_t written = 0;
+  while (written < content.size()) {
     ssize_t n = write(fd, content.data() + written, content.size() - written);
     if (n < 0) {
-      if (errno == EAGAIN) {
+      if (errno == EAGAIN || errno == EINTR) {
         continue;
       }
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+absl::Status WriteFile(absl::string_view file_name, int flags,
+                       absl::Span<const absl::string_view> pieces) {
+  // Use POSIX C APIs instead of C++ iostreams to avoid exceptions.
+  int fd = open(std::string(file_name).c_str(), O_WRONLY | O_CLOEXEC | flags,
+                0664);
+  if (fd == -1) {
+    return absl::UnknownError(
+        absl::StrFormat("Unable to open file: '%s'", file_name));
+  }
+  for (absl::string_view piece : pieces) {
+    if (!WriteAll(fd, piece)) {
       close(fd);
       return absl::UnknownError(
           absl::StrFormat("Unable to write to file: '%s'", file_name));
     }
-    written += n;
   }
   if (close(fd) != 0) {
     return absl::UnknownError(
@@ -59,6 +75,100 @@ absl::Status SetContents(absl::string_view file_name, absl::string_view content,
   return absl::OkStatus();
 }
 
+// Returns whether `file_name` exists and its content equals the concatenation
+// of `pieces`. The file is mapped, so comparing large files does not need to
+// copy them.
+bool HasContents(absl::string_view file_name,
+                 absl::Span<const absl::string_view> pieces) {
+  int fd = open(std::string(file_name).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  size_t size = 0;
+  for (absl::string_view piece : pieces) {
+    size += piece.size();
+  }
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      static_cast<size_t>(st.st_size) != size) {
+    close(fd);
+    return false;
+  }
+  if (size == 0) {
+    close(fd);
+    return true;
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  const char* current = static_cast<const char*>(data);
+  bool equal = true;
+  for (absl::string_view piece : pieces) {
+    if (memcmp(current, piece.data(), piece.size()) != 0) {
+      equal = false;
+      break;
+    }
+    current += piece.size();
+  }
+  munmap(data, size);
+  return equal;
+}
+
+// Writes `pieces` into a new temporary file next to `file_name` and then
+// renames that over `file_name`, so readers never see a partial file. The
+// replacement keeps the mode of an existing file. A symlink is written through
+// in place, as the rename would replace the link itself.
+absl::Status ReplaceContents(absl::string_view file_name,
+                             absl::Span<const absl::string_view> pieces) {
+  const std::string str_file_name(file_name);  // need zero termination
+  struct stat st;
+  const bool exists = lstat(str_file_name.c_str(), &st) == 0;
+  if (exists && S_ISLNK(st.st_mode)) {
+    return WriteFile(file_name, O_CREAT | O_TRUNC, pieces);
+  }
+  static std::atomic<int> counter{0};
+  const std::string temp_name =
+      absl::StrFormat("%s.tmp.%d.%d", file_name, getpid(), counter++);
+  if (auto status = WriteFile(temp_name, O_CREAT | O_EXCL, pieces);
+      !status.ok()) {
+    unlink(temp_name.c_str());
+    return status;
+  }
+  if (exists && chmod(temp_name.c_str(), st.st_mode & 07777) != 0) {
+    unlink(temp_name.c_str());
+    return absl::UnknownError(
+        absl::StrFormat("Unable to set the mode of '%s'", temp_name));
+  }
+  if (rename(temp_name.c_str(), str_file_name.c_str()) != 0) {
+    unlink(temp_name.c_str());
+    return absl::UnknownError(
+        absl::StrFormat("Unable to rename '%s' to '%s'", temp_name, file_name));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status SetContents(absl::string_view file_name, absl::string_view content,
+                         const Options& options) {
+  const absl::string_view pieces[] = {content};
+  return SetContents(file_name, pieces, options);
+}
+
+absl::Status SetContents(absl::string_view file_name,
+                         absl::Span<const absl::string_view> pieces,
+                         const Options& options) {
+  if (!options.write_if_changed) {
+    return WriteFile(file_name, O_CREAT | O_TRUNC, pieces);
+  }
+  if (HasContents(file_name, pieces)) {
+    return absl::OkStatus();
+  }
+  return ReplaceContents(file_name, pieces);
+}
+
 absl::Status Readable(absl::string_view file_name, const Options& options) {
   if (!std::filesystem::exists(file_name)) {
     return absl::NotFoundError(
@@ -16,7 +16,9 @@
 
 #include "proto_builder/oss/file.h"
 
+#include <chrono>
 #include <filesystem>
+#include <iterator>
 
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
@@ -28,6 +30,7 @@ namespace {
 namespace fs = ::std::filesystem;
 
 using ::testing::HasSubstr;
+using ::testing::status::oss::IsOkAndHolds;
 using ::testing::status::oss::StatusIs;
 
 static std::string TestName() {
@@ -45,6 +48,79 @@ TEST(FileTest, SetContents) {
   fs::remove_all(temp_dir);
 }
 
+TEST(FileTest, SetContentsPieces) {
+  std::error_code ec;
+  fs::path global_temp_dir = fs::temp_directory_path(ec);
+  ASSERT_EQ(ec.value(), 0);
+  fs::path temp_dir = (global_temp_dir / TestName());
+  fs::create_directory(temp_dir);
+  fs::path temp_file = temp_dir / "foo.txt";
+  const absl::string_view pieces[] = {"foo", "", "\nbar"};
+  EXPECT_OK(SetContents(temp_file.string(), pieces));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds("foo\nbar"));
+  EXPECT_OK(
+      SetContents(temp_file.string(), absl::Span<const absl::string_view>()));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds(""));
+  fs::remove_all(temp_dir);
+}
+
+TEST(FileTest, SetContentsWriteIfChanged) {
+  std::error_code ec;
+  fs::path global_temp_dir = fs::temp_directory_path(ec);
+  ASSERT_EQ(ec.value(), 0);
+  fs::path temp_dir = (global_temp_dir / TestName());
+  fs::create_directory(temp_dir);
+  fs::path temp_file = temp_dir / "foo.txt";
+  const Options options{.write_if_changed = true};
+  EXPECT_OK(SetContents(temp_file.string(), "foo", options));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds("foo"));
+  // Identical content must not touch the file.
+  const auto old_time = fs::last_write_time(temp_file) - std::chrono::hours(1);
+  fs::last_write_time(temp_file, old_time);
+  const absl::string_view pieces[] = {"f", "oo"};
+  EXPECT_OK(SetContents(temp_file.string(), pieces, options));
+  EXPECT_EQ(fs::last_write_time(temp_file), old_time);
+  // Different content replaces the file.
+  EXPECT_OK(SetContents(temp_file.string(), "bar", options));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds("bar"));
+  EXPECT_NE(fs::last_write_time(temp_file), old_time);
+  EXPECT_OK(SetContents(temp_file.string(), "", options));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds(""));
+  // No temporary files are left behind.
+  EXPECT_EQ(std::distance(fs::directory_iterator(temp_dir),
+                          fs::directory_iterator()),
+            1);
+  EXPECT_THAT(SetContents((temp_dir / "no_dir" / "foo.txt").string(), "foo",
+                          options),
+              StatusIs(absl::StatusCode::kUnknown));
+  fs::remove_all(temp_dir);
+}
+
+TEST(FileTest, SetContentsWriteIfChangedKeepsModeAndLinks) {
+  std::error_code ec;
+  fs::path global_temp_dir = fs::temp_directory_path(ec);
+  ASSERT_EQ(ec.value(), 0);
+  fs::path temp_dir = (global_temp_dir / TestName());
+  fs::create_directory(temp_dir);
+  fs::path temp_file = temp_dir / "foo.txt";
+  const Options options{.write_if_changed = true};
+  EXPECT_OK(SetContents(temp_file.string(), "foo", options));
+  const fs::perms perms = fs::perms::owner_read | fs::perms::owner_write |
+                          fs::perms::owner_exec | fs::perms::group_read;
+  fs::permissions(temp_file, perms);
+  EXPECT_OK(SetContents(temp_file.string(), "bar", options));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds("bar"));
+  EXPECT_EQ(fs::status(temp_file).permissions(), perms);
+  // A symlink stays a link and its target gets the content.
+  fs::path link = temp_dir / "link.txt";
+  fs::create_symlink(temp_file, link);
+  EXPECT_OK(SetContents(link.string(), "baz", options));
+  EXPECT_TRUE(fs::is_symlink(link));
+  EXPECT_THAT(GetContents(temp_file.string()), IsOkAndHolds("baz"));
+  EXPECT_EQ(fs::status(temp_file).permissions(), perms);
+  fs::remove_all(temp_dir);
+}
+
 TEST(FileTest, Readable) {
   std::error_code ec;
   fs::path global_temp_dir = fs::temp_directory_path(ec);
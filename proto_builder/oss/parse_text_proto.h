@@ -22,9 +22,13 @@
 #include "proto_builder/oss/qcheck.h"
 #include "proto_builder/oss/source_location.h"
 #include "google/protobuf/message.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 namespace proto_builder::oss {
 
@@ -52,6 +56,81 @@ T ParseTextOrDie(absl::string_view text_proto,
   return message;
 }
 
+// Parses the binary serialization in 'binary_proto' into a proto message of
+// type 'T', e.g. a header generated by the `text_proto_binary_library` rule.
+// The function dies if parsing fails.
+template <typename T>
+T ParseBinaryOrDie(absl::string_view binary_proto,
+                   SourceLocation loc = SourceLocation::current()) {
+  T message;
+  QCheck(message.ParseFromArray(binary_proto.data(),
+                                static_cast<int>(binary_proto.size())),
+         absl::StrFormat("ParseBinaryOrDie<%s>", T::GetDescriptor()->name())
+             .c_str(),
+         QCheckOptions::kDefault, loc);
+  return message;
+}
+
+namespace internal {
+
+// Process wide cache of parsed messages of type `T` keyed by their text. Entries
+// are never removed, so the returned references stay valid. Each thread keeps
+// its own index into the cache, so repeated lookups do not take the lock.
+template <typename T>
+class TextProtoCache final {
+ public:
+  static const T& Get(absl::string_view text_proto, SourceLocation loc) {
+    // Keys point into the node based `Shared()` entries which never move.
+    thread_local absl::flat_hash_map<absl::string_view, const T*> local;
+    const auto it = local.find(text_proto);
+    if (it != local.end()) {
+      return *it->second;
+    }
+    const auto& [text, message] = Intern(text_proto, loc);
+    local.emplace(text, &message);
+    return message;
+  }
+
+ private:
+  using Map = absl::node_hash_map<std::string, T>;
+
+  static const typename Map::value_type& Intern(absl::string_view text_proto,
+                                                SourceLocation loc) {
+    {
+      absl::MutexLock lock(&mu_);
+      const auto it = Shared().find(text_proto);
+      if (it != Shared().end()) {
+        return *it;
+      }
+    }
+    // Parse outside the lock, if another thread won the race its result stays.
+    T message = ParseTextOrDie<T>(text_proto, loc);
+    absl::MutexLock lock(&mu_);
+    return *Shared().try_emplace(text_proto, std::move(message)).first;
+  }
+
+  static Map& Shared() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    static auto& shared = *new Map();
+    return shared;
+  }
+
+  ABSL_CONST_INIT static absl::Mutex mu_;
+};
+
+template <typename T>
+ABSL_CONST_INIT absl::Mutex TextProtoCache<T>::mu_(absl::kConstInit);
+
+}  // namespace internal
+
+// Same as `ParseTextOrDie` but every distinct `text_proto` is only parsed once
+// per type 'T'. The result is interned for the lifetime of the process, so this
+// should only be used for a bounded set of texts, e.g. string literals.
+template <typename T>
+const T& ParseTextCachedOrDie(absl::string_view text_proto,
+                              SourceLocation loc = SourceLocation::current()) {
+  return internal::TextProtoCache<T>::Get(text_proto, loc);
+}
+
 class ParseTextProtoHelper final {
  public:
   ParseTextProtoHelper(absl::string_view text_proto, SourceLocation loc)
@@ -16,6 +16,10 @@
 
 #include "proto_builder/oss/parse_text_proto.h"
 
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
 #include "proto_builder/oss/tests/simple_message.pb.h"
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
@@ -23,6 +27,8 @@
 namespace proto_builder::oss {
 namespace {
 
+using ::testing::Each;
+using ::testing::Eq;
 using ::testing::oss::EqualsProto;
 
 class ParseTextProtoTest : public ::testing::Test {};
@@ -42,5 +48,47 @@ TEST_F(ParseTextProtoTest, ParseError) {
                "INVALID_ARGUMENT: Line 0, Col 0: Expected identifier, got: !");
 }
 
+TEST_F(ParseTextProtoTest, ParseBinary) {
+  EXPECT_THAT(ParseBinaryOrDie<SimpleMessage>(""), EqualsProto(""));
+  const std::string binary = ParseTextOrDie<SimpleMessage>("one: 42 two: 0")
+                                 .SerializeAsString();
+  EXPECT_THAT(ParseBinaryOrDie<SimpleMessage>(binary),
+              EqualsProto("one: 42 two: 0"));
+  EXPECT_DEATH(ParseBinaryOrDie<SimpleMessage>("\xff"),
+               "Check failed: ParseBinaryOrDie<SimpleMessage>");
+}
+
+TEST_F(ParseTextProtoTest, ParseCached) {
+  const SimpleMessage& first = ParseTextCachedOrDie<SimpleMessage>("one: 42");
+  EXPECT_THAT(first, EqualsProto("one: 42"));
+  // The same text returns the interned message, even from another buffer.
+  const std::string text = "one: 42";
+  EXPECT_EQ(&ParseTextCachedOrDie<SimpleMessage>(text), &first);
+  EXPECT_THAT(ParseTextCachedOrDie<SimpleMessage>("one: 25"),
+              EqualsProto("one: 25"));
+  EXPECT_THAT(first, EqualsProto("one: 42"));
+}
+
+TEST_F(ParseTextProtoTest, ParseCachedThreads) {
+  std::vector<const SimpleMessage*> results(8);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&result] {
+      result = &ParseTextCachedOrDie<SimpleMessage>("one: 1 two: 2");
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_THAT(results, Each(Eq(results[0])));
+  EXPECT_THAT(*results[0], EqualsProto("one: 1 two: 2"));
+}
+
+TEST_F(ParseTextProtoTest, ParseCachedError) {
+  EXPECT_DEATH(ParseTextCachedOrDie<oss::SimpleMessage>("!!!"),
+               "Check failed: ParseTextOrDie<SimpleMessage>\n"
+               "INVALID_ARGUMENT: Line 0, Col 0: Expected identifier, got: !");
+}
+
 }  // namespace
 }  // namespace proto_builder::oss
@@ -25,19 +25,108 @@
 #include "proto_builder/oss/sourcefile_database.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "gtest/gtest.h"
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
 
 ABSL_FLAG(std::string, proto_type, "", "Proto message type.");
 ABSL_FLAG(std::string, textproto, "", "File with textproto data.");
+ABSL_FLAG(std::string, binary_header, "",
+          "If set, writes a C++ header to this file that embeds the binary "
+          "serialization of the textproto (see `--binary_name`).");
+ABSL_FLAG(std::string, binary_name, "kBinaryProto",
+          "Name of the `constexpr absl::string_view` in `--binary_header`, "
+          "may be qualified by a namespace (e.g. 'foo::bar::kConfig').");
 
 namespace proto_builder::oss {
 
+namespace {
+
+// Serializes deterministically, so that the generated header is reproducible.
+std::string SerializeDeterministic(const google::protobuf::Message& message) {
+  std::string result;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&result);
+    google::protobuf::io::CodedOutputStream stream(&string_stream);
+    stream.SetSerializationDeterministic(true);
+    QCHECK(message.SerializeToCodedStream(&stream));
+  }
+  return result;
+}
+
+std::string HeaderGuard(absl::string_view header) {
+  // Bazel writes to 'bazel-out/<config>/bin/<package>/...'.
+  const size_t bin = header.find("/bin/");
+  if (bin != absl::string_view::npos) {
+    header.remove_prefix(bin + 5);
+  }
+  std::string guard = absl::AsciiStrToUpper(header);
+  for (char& c : guard) {
+    if (!absl::ascii_isalnum(c)) {
+      c = '_';
+    }
+  }
+  return absl::StrCat(guard, "_");
+}
+
+// Creates a header that defines `name` as a `constexpr absl::string_view` that
+// holds the binary serialization of `message`. The data is written as a string
+// literal with explicit length, so it may contain '\0' characters.
+std::string BinaryHeader(const google::protobuf::Message& message,
+                         absl::string_view textproto_file,
+                         absl::string_view header, absl::string_view name) {
+  std::vector<std::string> namespaces = absl::StrSplit(name, "::");
+  const std::string variable = namespaces.back();
+  namespaces.pop_back();
+  const std::string guard = HeaderGuard(header);
+  const std::string data = SerializeDeterministic(message);
+  std::string result = absl::StrCat(
+      "// Generated from '", textproto_file, "' (",
+      message.GetDescriptor()->full_name(), "), DO NOT EDIT.\n\n",
+      "#ifndef ", guard, "\n#define ", guard, "\n\n",
+      "#include \"absl/strings/string_view.h\"\n\n");
+  for (const auto& ns : namespaces) {
+    absl::StrAppend(&result, "namespace ", ns, " {\n");
+  }
+  if (!namespaces.empty()) {
+    absl::StrAppend(&result, "\n");
+  }
+  // CEscape uses 3 digit octal escapes, those cannot swallow the next
+  // character like hex escapes would.
+  constexpr size_t kBytesPerLine = 16;
+  std::vector<std::string> lines;
+  for (size_t pos = 0; pos < data.size(); pos += kBytesPerLine) {
+    lines.push_back(absl::StrCat(
+        "\"", absl::CEscape(data.substr(pos, kBytesPerLine)), "\""));
+  }
+  if (lines.empty()) {
+    lines.push_back("\"\"");
+  }
+  absl::StrAppend(&result, "inline constexpr absl::string_view ", variable,
+                  "(\n    ", absl::StrJoin(lines, "\n    "), ",\n    ",
+                  data.size(), ");\n");
+  if (!namespaces.empty()) {
+    absl::StrAppend(&result, "\n");
+  }
+  for (auto ns = namespaces.rbegin(); ns != namespaces.rend(); ++ns) {
+    absl::StrAppend(&result, "}  // namespace ", *ns, "\n");
+  }
+  absl::StrAppend(&result, "\n#endif  // ", guard, "\n");
+  return result;
+}
+
+}  // namespace
+
 void Load(int argc, char** argv) {
   // Prepare
   std::vector<std::string> proto_paths =
@@ -71,6 +160,14 @@ void Load(int argc, char** argv) {
 
   // Parse
   QCHECK_OK(internal::ParseTextInternal(proto_text, message.get(), source));
+
+  const std::string binary_header = absl::GetFlag(FLAGS_binary_header);
+  if (!binary_header.empty()) {
+    QCHECK_OK(file::oss::SetContents(
+        binary_header,
+        BinaryHeader(*message, textproto_file, binary_header,
+                     absl::GetFlag(FLAGS_binary_name))));
+  }
 }
 
 }  // namespace proto_builder::oss
@@ -0,0 +1,144 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/persistent_worker.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "proto_builder/oss/worker_protocol.pb.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "absl/flags/commandlineflag.h"
+#include "absl/flags/reflection.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+namespace proto_builder::oss {
+
+using ::google::protobuf::io::FileInputStream;
+using ::google::protobuf::io::FileOutputStream;
+using ::google::protobuf::util::ParseDelimitedFromZeroCopyStream;
+using ::google::protobuf::util::SerializeDelimitedToZeroCopyStream;
+using ::proto_builder::oss::worker::WorkRequest;
+using ::proto_builder::oss::worker::WorkResponse;
+
+absl::Status RunPersistentWorker(int input_fd, int output_fd,
+                                 const WorkHandler& handler) {
+  FileInputStream input(input_fd);
+  FileOutputStream output(output_fd);
+  while (true) {
+    WorkRequest request;
+    bool clean_eof = false;
+    if (!ParseDelimitedFromZeroCopyStream(&request, &input, &clean_eof)) {
+      if (clean_eof) {
+        return absl::OkStatus();
+      }
+      return absl::DataLossError("Unable to read WorkRequest.");
+    }
+    WorkResponse response;
+    response.set_request_id(request.request_id());
+    if (request.cancel()) {
+      // Requests are handled synchronously, so there is nothing to cancel.
+      response.set_was_cancelled(true);
+    } else {
+      const std::vector<std::string> arguments(request.arguments().begin(),
+                                               request.arguments().end());
+      response.set_exit_code(handler(arguments, response.mutable_output()));
+    }
+    if (!SerializeDelimitedToZeroCopyStream(response, &output) ||
+        !output.Flush()) {
+      return absl::UnknownError("Unable to write WorkResponse.");
+    }
+  }
+}
+
+absl::StatusOr<int> RedirectOutputToLog(int protocol_fd, int log_fd) {
+  std::cout.flush();
+  std::fflush(stdout);
+  const int fd = dup(protocol_fd);
+  if (fd < 0) {
+    return absl::InternalError(
+        absl::StrCat("Unable to duplicate output: ", std::strerror(errno)));
+  }
+  if (dup2(log_fd, protocol_fd) < 0) {
+    const int error = errno;
+    close(fd);
+    return absl::InternalError(
+        absl::StrCat("Unable to redirect output: ", std::strerror(error)));
+  }
+  return fd;
+}
+
+absl::Status SetFlagsFromArguments(const std::vector<std::string>& arguments) {
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    absl::string_view arg = arguments[i];
+    if (!absl::ConsumePrefix(&arg, "--") && !absl::ConsumePrefix(&arg, "-")) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unexpected positional argument: '", arg, "'"));
+    }
+    absl::string_view name = arg;
+    absl::string_view value;
+    bool has_value = false;
+    if (const size_t pos = arg.find('='); pos != absl::string_view::npos) {
+      name = arg.substr(0, pos);
+      value = arg.substr(pos + 1);
+      has_value = true;
+    }
+    absl::CommandLineFlag* flag = absl::FindCommandLineFlag(name);
+    if (flag == nullptr && !has_value && absl::ConsumePrefix(&name, "no")) {
+      flag = absl::FindCommandLineFlag(name);
+      if (flag != nullptr && flag->IsOfType<bool>()) {
+        value = "false";
+        has_value = true;
+      } else {
+        flag = nullptr;
+      }
+    }
+    if (flag == nullptr) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unknown command line flag: '", arguments[i], "'"));
+    }
+    if (!has_value) {
+      if (flag->IsOfType<bool>()) {
+        value = "true";
+      } else if (i + 1 < arguments.size()) {
+        value = arguments[++i];
+      } else {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Missing value for flag: '", arguments[i], "'"));
+      }
+    }
+    std::string error;
+    if (!flag->ParseFrom(value, &error)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Illegal value for flag '", flag->Name(), "': ", error));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace proto_builder::oss
@@ -0,0 +1,59 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_PERSISTENT_WORKER_H_
+#define PROTO_BUILDER_OSS_PERSISTENT_WORKER_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+
+namespace proto_builder::oss {
+
+// Handles a single work request. Receives the arguments of the request, may
+// append diagnostics for the user to `output` and returns the exit code.
+using WorkHandler = std::function<int(const std::vector<std::string>& arguments,
+                                      std::string* output)>;
+
+// Implements the (singleplex) Bazel persistent worker protocol: Reads length
+// delimited WorkRequest messages from `input_fd` until end of file, calls
+// `handler` for each and writes the WorkResponse to `output_fd`.
+//
+// Returns an error if a request could not be read or a response could not be
+// written. Reaching the end of `input_fd` is not an error.
+absl::Status RunPersistentWorker(int input_fd, int output_fd,
+                                 const WorkHandler& handler);
+
+// Reserves `protocol_fd` for the worker protocol: Returns a duplicate of
+// `protocol_fd` to be passed to RunPersistentWorker and then points
+// `protocol_fd` at `log_fd`. Bazel reads WorkResponses from stdout, so a worker
+// calls this with STDOUT_FILENO and STDERR_FILENO before handling requests.
+// Otherwise anything written to std::cout (e.g. LOG(INFO) or a failed QCHECK)
+// would corrupt the length delimited responses.
+absl::StatusOr<int> RedirectOutputToLog(int protocol_fd, int log_fd);
+
+// Sets absl flags from command line style `arguments`. Supported are
+// `--name=value`, `--name value` as well as `--name` and `--noname` for boolean
+// flags. A single dash may be used instead of two. Flags not mentioned keep
+// their current value.
+absl::Status SetFlagsFromArguments(const std::vector<std::string>& arguments);
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_PERSISTENT_WORKER_H_
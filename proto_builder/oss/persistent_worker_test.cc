@@ -0,0 +1,215 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/persistent_worker.h"
+
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/worker_protocol.pb.h"
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "absl/strings/str_join.h"
+
+ABSL_FLAG(std::string, worker_test_string, "default", "For testing only.");
+ABSL_FLAG(int, worker_test_int, 0, "For testing only.");
+ABSL_FLAG(bool, worker_test_bool, false, "For testing only.");
+
+namespace proto_builder::oss {
+namespace {
+
+using ::google::protobuf::io::FileInputStream;
+using ::google::protobuf::io::FileOutputStream;
+using ::google::protobuf::util::ParseDelimitedFromZeroCopyStream;
+using ::google::protobuf::util::SerializeDelimitedToZeroCopyStream;
+using ::proto_builder::oss::worker::WorkRequest;
+using ::proto_builder::oss::worker::WorkResponse;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+using ::testing::status::oss::StatusIs;
+
+TEST(SetFlagsFromArgumentsTest, SetsFlags) {
+  absl::FlagSaver flag_saver;
+  EXPECT_OK(SetFlagsFromArguments({"--worker_test_string=foo",
+                                   "-worker_test_int", "42",
+                                   "--worker_test_bool"}));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_string), Eq("foo"));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_int), Eq(42));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_bool), Eq(true));
+  EXPECT_OK(SetFlagsFromArguments(
+      {"--noworker_test_bool", "--worker_test_string="}));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_string), Eq(""));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_int), Eq(42));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_bool), Eq(false));
+  EXPECT_OK(SetFlagsFromArguments({"--worker_test_bool=True"}));
+  EXPECT_THAT(absl::GetFlag(FLAGS_worker_test_bool), Eq(true));
+}
+
+TEST(SetFlagsFromArgumentsTest, Errors) {
+  absl::FlagSaver flag_saver;
+  EXPECT_THAT(SetFlagsFromArguments({"worker_test_int"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unexpected positional argument")));
+  EXPECT_THAT(SetFlagsFromArguments({"--worker_test_unknown=1"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unknown command line flag")));
+  EXPECT_THAT(SetFlagsFromArguments({"--noworker_test_int"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unknown command line flag")));
+  EXPECT_THAT(SetFlagsFromArguments({"--worker_test_int"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Missing value for flag")));
+  EXPECT_THAT(SetFlagsFromArguments({"--worker_test_int=x"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Illegal value for flag 'worker_test_int'")));
+}
+
+class PersistentWorkerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(pipe(request_pipe_), Eq(0));
+    ASSERT_THAT(pipe(response_pipe_), Eq(0));
+  }
+
+  void TearDown() override {
+    close(request_pipe_[0]);
+    close(response_pipe_[0]);
+    close(response_pipe_[1]);
+  }
+
+  void SendRequests(const std::vector<WorkRequest>& requests) {
+    {
+      FileOutputStream output(request_pipe_[1]);
+      for (const WorkRequest& request : requests) {
+        ASSERT_TRUE(SerializeDelimitedToZeroCopyStream(request, &output));
+      }
+    }
+    close(request_pipe_[1]);
+  }
+
+  absl::Status Run() {
+    return RunPersistentWorker(
+        request_pipe_[0], response_pipe_[1],
+        [](const std::vector<std::string>& arguments, std::string* output) {
+          *output = absl::StrJoin(arguments, " ");
+          return static_cast<int>(arguments.size());
+        });
+  }
+
+  std::vector<WorkResponse> ReadResponses() {
+    close(response_pipe_[1]);
+    response_pipe_[1] = -1;
+    std::vector<WorkResponse> responses;
+    FileInputStream input(response_pipe_[0]);
+    WorkResponse response;
+    while (ParseDelimitedFromZeroCopyStream(&response, &input, nullptr)) {
+      responses.push_back(response);
+    }
+    return responses;
+  }
+
+  int request_pipe_[2];
+  int response_pipe_[2];
+};
+
+TEST_F(PersistentWorkerTest, RespondsToEachRequest) {
+  WorkRequest first;
+  first.add_arguments("--a=1");
+  first.add_arguments("--b");
+  WorkRequest second;
+  second.set_request_id(7);
+  second.add_arguments("--c");
+  WorkRequest cancel;
+  cancel.set_request_id(8);
+  cancel.set_cancel(true);
+  SendRequests({first, second, cancel});
+  EXPECT_OK(Run());
+  const std::vector<WorkResponse> responses = ReadResponses();
+  ASSERT_THAT(responses.size(), Eq(3));
+  EXPECT_THAT(responses[0].exit_code(), Eq(2));
+  EXPECT_THAT(responses[0].output(), Eq("--a=1 --b"));
+  EXPECT_THAT(responses[0].request_id(), Eq(0));
+  EXPECT_THAT(responses[1].exit_code(), Eq(1));
+  EXPECT_THAT(responses[1].output(), Eq("--c"));
+  EXPECT_THAT(responses[1].request_id(), Eq(7));
+  EXPECT_THAT(responses[2].was_cancelled(), Eq(true));
+  EXPECT_THAT(responses[2].request_id(), Eq(8));
+}
+
+TEST_F(PersistentWorkerTest, NoRequests) {
+  SendRequests({});
+  EXPECT_OK(Run());
+  EXPECT_THAT(ReadResponses().size(), Eq(0));
+}
+
+TEST_F(PersistentWorkerTest, BrokenRequest) {
+  ASSERT_THAT(write(request_pipe_[1], "\x05" "ab", 3), Eq(3));
+  close(request_pipe_[1]);
+  EXPECT_THAT(Run(), StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST_F(PersistentWorkerTest, LoggingDoesNotCorruptResponses) {
+  // Simulate Bazel, which reads the responses from the worker's stdout.
+  std::cout.flush();
+  const int saved_stdout = dup(STDOUT_FILENO);
+  ASSERT_THAT(saved_stdout, Ge(0));
+  ASSERT_THAT(dup2(response_pipe_[1], STDOUT_FILENO), Eq(STDOUT_FILENO));
+  int log_pipe[2];
+  ASSERT_THAT(pipe(log_pipe), Eq(0));
+  const absl::StatusOr<int> protocol_fd =
+      RedirectOutputToLog(STDOUT_FILENO, log_pipe[1]);
+  ASSERT_OK(protocol_fd.status());
+  WorkRequest request;
+  request.set_request_id(3);
+  request.add_arguments("--log");
+  SendRequests({request});
+  const absl::Status status = RunPersistentWorker(
+      request_pipe_[0], *protocol_fd,
+      [](const std::vector<std::string>& arguments, std::string* output) {
+        LOG(INFO) << "Logged while handling " << arguments[0];
+        std::cout << "Printed to stdout" << std::endl;
+        return 0;
+      });
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+  close(*protocol_fd);
+  close(log_pipe[1]);
+  EXPECT_OK(status);
+  const std::vector<WorkResponse> responses = ReadResponses();
+  ASSERT_THAT(responses.size(), Eq(1));
+  EXPECT_THAT(responses[0].request_id(), Eq(3));
+  EXPECT_THAT(responses[0].exit_code(), Eq(0));
+  std::string log(1024, '\0');
+  const ssize_t size = read(log_pipe[0], log.data(), log.size());
+  close(log_pipe[0]);
+  ASSERT_THAT(size, Gt(0));
+  log.resize(size);
+  EXPECT_THAT(log, HasSubstr("Logged while handling --log"));
+  EXPECT_THAT(log, HasSubstr("Printed to stdout"));
+}
+
+}  // namespace
+}  // namespace proto_builder::oss
@@ -0,0 +1,139 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/source_location.h"
+
+#ifndef PBCC_NO_SOURCE_LOCATION
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace proto_builder::oss {
+
+namespace {
+
+constexpr absl::string_view kPayloadUrl = "proto_builder/source_location";
+
+struct InternedLocations {
+  // File names are compared by address: the same file may get more than one
+  // id if its name literal is not merged, which is harmless.
+  absl::flat_hash_map<std::pair<const char*, int>, SourceLocationId> ids;
+  // Location of id `i` at index `i - 1`.
+  std::vector<SourceLocation> locations;
+};
+
+ABSL_CONST_INIT absl::Mutex interned_mu(absl::kConstInit);
+
+InternedLocations& GetInternedLocations()
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(interned_mu) {
+  static auto& interned = *new InternedLocations();
+  return interned;
+}
+
+}  // namespace
+
+SourceLocationId InternSourceLocation(SourceLocation src_loc) {
+  absl::MutexLock lock(&interned_mu);
+  InternedLocations& interned = GetInternedLocations();
+  const auto [it, inserted] = interned.ids.try_emplace(
+      std::make_pair(src_loc.file_name(), src_loc.line()),
+      interned.locations.size() + 1);
+  if (inserted) {
+    interned.locations.push_back(src_loc);
+  }
+  return it->second;
+}
+
+absl::optional<SourceLocation> GetInternedSourceLocation(SourceLocationId id) {
+  absl::MutexLock lock(&interned_mu);
+  const InternedLocations& interned = GetInternedLocations();
+  if (id == 0 || id > interned.locations.size()) {
+    return absl::nullopt;
+  }
+  return interned.locations[id - 1];
+}
+
+#ifdef PBCC_COMPACT_SOURCE_LOCATION
+void AddSourceLocationToStatus(SourceLocation src_loc, absl::Status& status) {
+  const SourceLocationId id = InternSourceLocation(src_loc);
+  // Four bytes fit into the inline storage of the Cord.
+  const char bytes[] = {
+      static_cast<char>(id & 0xFF), static_cast<char>((id >> 8) & 0xFF),
+      static_cast<char>((id >> 16) & 0xFF), static_cast<char>(id >> 24)};
+  status.SetPayload(kPayloadUrl,
+                    absl::Cord(absl::string_view(bytes, sizeof(bytes))));
+}
+
+absl::optional<SourceLocation> GetSourceLocation(const absl::Status& status) {
+  const absl::optional<absl::Cord> payload = status.GetPayload(kPayloadUrl);
+  if (!payload.has_value() || payload->size() != sizeof(SourceLocationId)) {
+    return absl::nullopt;
+  }
+  SourceLocationId id = 0;
+  int shift = 0;
+  for (const char c : payload->Chars()) {
+    id |= static_cast<SourceLocationId>(static_cast<unsigned char>(c)) << shift;
+    shift += 8;
+  }
+  return GetInternedSourceLocation(id);
+}
+#else   // PBCC_COMPACT_SOURCE_LOCATION
+void AddSourceLocationToStatus(SourceLocation src_loc, absl::Status& status) {
+  // Interning lets `GetSourceLocation` return a location with a file name that
+  // outlives the status.
+  InternSourceLocation(src_loc);
+  status.SetPayload(
+      kPayloadUrl,
+      absl::Cord(absl::StrCat(src_loc.file_name(), ":", src_loc.line())));
+}
+
+absl::optional<SourceLocation> GetSourceLocation(const absl::Status& status) {
+  const absl::optional<absl::Cord> payload = status.GetPayload(kPayloadUrl);
+  if (!payload.has_value()) {
+    return absl::nullopt;
+  }
+  const std::string text(*payload);
+  const size_t colon = text.rfind(':');
+  int line = 0;
+  if (colon == std::string::npos ||
+      !absl::SimpleAtoi(absl::string_view(text).substr(colon + 1), &line)) {
+    return absl::nullopt;
+  }
+  const absl::string_view file_name = absl::string_view(text).substr(0, colon);
+  // Only locations of this process can be found. This is not on the error
+  // path, so a linear search is fine.
+  absl::MutexLock lock(&interned_mu);
+  for (const SourceLocation& location : GetInternedLocations().locations) {
+    if (location.line() == line && location.file_name() == file_name) {
+      return location;
+    }
+  }
+  return absl::nullopt;
+}
+#endif  // PBCC_COMPACT_SOURCE_LOCATION
+
+}  // namespace proto_builder::oss
+
+#endif  // PBCC_NO_SOURCE_LOCATION
@@ -17,15 +17,22 @@
 #ifndef PROTO_BUILDER_OSS_SOURCE_LOCATION_H_
 #define PROTO_BUILDER_OSS_SOURCE_LOCATION_H_
 
+#include <cstdint>
+
 #include "absl/status/status.h"
-#include "absl/strings/cord.h"
-#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 
 namespace proto_builder::oss {
 
 // Class representing a specific location in the source code of a program.
+//
+// Defining `PBCC_NO_SOURCE_LOCATION` turns this into an empty type whose
+// `current()` captures nothing, so that builders and setters taking a location
+// parameter do not pay for it (e.g. in optimized builds). The define must be
+// the same for all translation units of a program.
 class SourceLocation {
  public:
+#ifndef PBCC_NO_SOURCE_LOCATION
   // Avoid this constructor; it populates the object with dummy values.
   constexpr SourceLocation() : line_(0), file_name_(nullptr) {}
 
@@ -65,15 +72,54 @@ class SourceLocation {
 
   int line_;
   const char* file_name_;
+#else   // PBCC_NO_SOURCE_LOCATION
+  constexpr SourceLocation() = default;
+  static constexpr SourceLocation current() { return SourceLocation(); }
+  constexpr int line() const { return 0; }
+  constexpr const char* file_name() const { return ""; }
+
+ private:
+  constexpr SourceLocation(int, const char*) {}
+#endif  // PBCC_NO_SOURCE_LOCATION
   friend void Load(int, char**);
 };
 
-inline void AddSourceLocationToStatus(SourceLocation src_loc,
-                                      absl::Status& status) {
-  status.SetPayload(
-      "proto_builder/source_location",
-      absl::Cord(absl::StrCat(src_loc.file_name(), ":", src_loc.line())));
+// Compact id of an interned `SourceLocation`, only valid within the process
+// that interned it. Id 0 is never assigned.
+using SourceLocationId = uint32_t;
+
+#ifndef PBCC_NO_SOURCE_LOCATION
+// Returns the id of `src_loc`, assigning the next free id on first use.
+SourceLocationId InternSourceLocation(SourceLocation src_loc);
+
+// Returns the location that was interned as `id`, if any.
+absl::optional<SourceLocation> GetInternedSourceLocation(SourceLocationId id);
+
+// Attaches `src_loc` to `status` as a readable "file:line" payload.
+//
+// Defining `PBCC_COMPACT_SOURCE_LOCATION` for this library makes the payload
+// hold the interned id instead, so nothing gets formatted or allocated on the
+// error path. `status.ToString()` then shows the escaped id and the location
+// can only be resolved with `GetSourceLocation` in the same process.
+void AddSourceLocationToStatus(SourceLocation src_loc, absl::Status& status);
+
+// Returns the location added by `AddSourceLocationToStatus` in this process,
+// if any.
+absl::optional<SourceLocation> GetSourceLocation(const absl::Status& status);
+#else   // PBCC_NO_SOURCE_LOCATION
+inline SourceLocationId InternSourceLocation(SourceLocation) { return 0; }
+
+inline absl::optional<SourceLocation> GetInternedSourceLocation(
+    SourceLocationId) {
+  return absl::nullopt;
+}
+
+inline void AddSourceLocationToStatus(SourceLocation, absl::Status&) {}
+
+inline absl::optional<SourceLocation> GetSourceLocation(const absl::Status&) {
+  return absl::nullopt;
 }
+#endif  // PBCC_NO_SOURCE_LOCATION
 
 }  // namespace proto_builder::oss
 
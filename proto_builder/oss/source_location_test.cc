@@ -16,9 +16,14 @@
 
 #include "proto_builder/oss/source_location.h"
 
+#include <string>
+#include <type_traits>
+
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 #include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 
@@ -26,10 +31,12 @@ namespace proto_builder::oss {
 namespace {
 
 using ::testing::EndsWith;
+using ::testing::HasSubstr;
 using ::testing::Not;
 
 class SourceLocationTest : public ::testing::Test {};
 
+#ifndef PBCC_NO_SOURCE_LOCATION
 TEST_F(SourceLocationTest, Current) {
   SourceLocation location = SourceLocation::current();
 
@@ -37,17 +44,94 @@ TEST_F(SourceLocationTest, Current) {
   EXPECT_THAT(location.file_name(), EndsWith("source_location_test.cc"));
 }
 
+TEST_F(SourceLocationTest, InternSourceLocation) {
+  const SourceLocation first = SourceLocation::current();
+  const SourceLocation second = SourceLocation::current();
+  const SourceLocationId id = InternSourceLocation(first);
+  EXPECT_NE(id, 0);
+  EXPECT_EQ(InternSourceLocation(first), id);
+  EXPECT_NE(InternSourceLocation(second), id);
+  const absl::optional<SourceLocation> interned = GetInternedSourceLocation(id);
+  ASSERT_TRUE(interned.has_value());
+  EXPECT_EQ(interned->line(), first.line());
+  EXPECT_EQ(interned->file_name(), first.file_name());
+  EXPECT_FALSE(GetInternedSourceLocation(0).has_value());
+}
+
 TEST_F(SourceLocationTest, AddSourceLocationToStatus) {
   absl::Status status = absl::InternalError("");
-  const size_t line = __LINE__ + 1;
+  EXPECT_FALSE(GetSourceLocation(status).has_value());
+  const int line = __LINE__ + 1;
   AddSourceLocationToStatus(SourceLocation::current(), status);
-  absl::optional<absl::Cord> payload =
+  const absl::optional<SourceLocation> location = GetSourceLocation(status);
+  ASSERT_TRUE(location.has_value());
+  EXPECT_EQ(location->line(), line);
+  EXPECT_THAT(location->file_name(), EndsWith("source_location_test.cc"));
+}
+
+#ifndef PBCC_COMPACT_SOURCE_LOCATION
+TEST_F(SourceLocationTest, StatusToStringShowsTheLocation) {
+  absl::Status status = absl::InternalError("error");
+  const SourceLocation src_loc = SourceLocation::current();
+  AddSourceLocationToStatus(src_loc, status);
+  const absl::optional<absl::Cord> payload =
       status.GetPayload("proto_builder/source_location");
   ASSERT_THAT(payload, Not(absl::nullopt));
-  std::string s;
-  absl::CopyCordToString(payload.value(), &s);
-  EXPECT_THAT(s, absl::StrCat(__FILE__, ":", line));
+  EXPECT_EQ(std::string(*payload),
+            absl::StrCat(src_loc.file_name(), ":", src_loc.line()));
+  EXPECT_THAT(status.ToString(),
+              HasSubstr(absl::StrCat("source_location_test.cc:",
+                                     src_loc.line())));
+}
+
+TEST_F(SourceLocationTest, GetSourceLocationOfUnknownLocation) {
+  absl::Status status = absl::InternalError("error");
+  status.SetPayload("proto_builder/source_location",
+                    absl::Cord("other_process.cc:12"));
+  EXPECT_FALSE(GetSourceLocation(status).has_value());
+  status.SetPayload("proto_builder/source_location", absl::Cord("no_line"));
+  EXPECT_FALSE(GetSourceLocation(status).has_value());
+}
+#else   // PBCC_COMPACT_SOURCE_LOCATION
+TEST_F(SourceLocationTest, StatusToStringShowsTheId) {
+  absl::Status status = absl::InternalError("error");
+  const SourceLocation src_loc = SourceLocation::current();
+  const SourceLocationId id = InternSourceLocation(src_loc);
+  AddSourceLocationToStatus(src_loc, status);
+  // `ToString` prints the escaped little endian id, not "file:line".
+  const std::string id_bytes = {
+      static_cast<char>(id & 0xFF), static_cast<char>((id >> 8) & 0xFF),
+      static_cast<char>((id >> 16) & 0xFF), static_cast<char>(id >> 24)};
+  const std::string text = status.ToString();
+  EXPECT_THAT(text, HasSubstr(absl::StrCat("[proto_builder/source_location='",
+                                           absl::CHexEscape(id_bytes), "']")));
+  EXPECT_THAT(text, Not(HasSubstr("source_location_test.cc")));
+  // Copies of the status resolve to the same location within the process.
+  const absl::Status copy = status;
+  const absl::optional<SourceLocation> location = GetSourceLocation(copy);
+  ASSERT_TRUE(location.has_value());
+  EXPECT_EQ(location->line(), src_loc.line());
+  EXPECT_EQ(location->file_name(), src_loc.file_name());
+}
+#endif  // PBCC_COMPACT_SOURCE_LOCATION
+#else   // PBCC_NO_SOURCE_LOCATION
+TEST_F(SourceLocationTest, CapturesNothing) {
+  static_assert(std::is_empty_v<SourceLocation>);
+  const SourceLocation location = SourceLocation::current();
+  EXPECT_EQ(location.line(), 0);
+  EXPECT_STREQ(location.file_name(), "");
+  EXPECT_EQ(InternSourceLocation(location), 0);
+  EXPECT_FALSE(GetInternedSourceLocation(0).has_value());
+}
+
+TEST_F(SourceLocationTest, AddSourceLocationToStatusAddsNoPayload) {
+  absl::Status status = absl::InternalError("error");
+  AddSourceLocationToStatus(SourceLocation::current(), status);
+  EXPECT_FALSE(GetSourceLocation(status).has_value());
+  EXPECT_EQ(status.GetPayload("proto_builder/source_location"), absl::nullopt);
+  EXPECT_EQ(status.ToString(), "INTERNAL: error");
 }
+#endif  // PBCC_NO_SOURCE_LOCATION
 
 }  // namespace
 }  // namespace proto_builder::oss
@@ -38,18 +38,53 @@ class SourceFileDatabase {
       const std::vector<std::string>& proto_files,
       const std::vector<std::string>& proto_paths);
 
+  // Create a new protocol database from serialized FileDescriptorSets (e.g. as
+  // written by `protoc --descriptor_set_out` or Bazel's `proto_library`). Files
+  // are only taken from the sets, no .proto file gets parsed. The sets must be
+  // complete, that is contain all transitive imports. Files that appear in
+  // multiple sets are only loaded once. If `use_mmap` is set, then the sets are
+  // memory mapped rather than read.
+  //
+  // proto_files and proto_paths have the same meaning as for `New`. However
+  // proto_files are not read, they get mapped to the names in the sets using
+  // proto_paths. See `FindFileByName`.
+  //
+  // Returns pointer to newly created instance.
+  static std::unique_ptr<SourceFileDatabase> NewFromDescriptorSets(
+      const std::vector<std::string>& descriptor_sets,
+      const std::vector<std::string>& proto_files,
+      const std::vector<std::string>& proto_paths, bool use_mmap = true);
+
   // Returns `--protofiles` as a vector.
   static std::vector<std::string> GetProtoFilesFlag();
 
   // Returns `--proto_paths` as a vector.
   static std::vector<std::string> GetProtoPathsFlag();
 
+  // Returns `--descriptor_set_in` as a vector.
+  static std::vector<std::string> GetDescriptorSetInFlag();
+
+  // Returns `--descriptor_set_mmap`.
+  static bool GetDescriptorSetMmapFlag();
+
+  // If enabled, then parsed proto files are kept for the lifetime of the
+  // process and shared between all instances. A cached file is only reused as
+  // long as its content does not change. This is meant for long running
+  // processes that load overlapping sets of files (e.g. persistent workers).
+  static void SetCacheParsedFiles(bool enable);
+
   virtual ~SourceFileDatabase() = default;
 
   virtual const ::google::protobuf::DescriptorPool* pool() const = 0;
   virtual bool LoadedSuccessfully() const = 0;
   virtual std::vector<std::string> GetErrors() const = 0;
 
+  // Find a file by the name it was loaded as (the names in `proto_files`).
+  virtual const ::google::protobuf::FileDescriptor* FindFileByName(
+      const std::string& proto_file) const {
+    return pool()->FindFileByName(proto_file);
+  }
+
  protected:
   // The class must be overridden and may not be instantiated.
   SourceFileDatabase() = default;
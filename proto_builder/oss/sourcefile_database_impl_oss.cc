@@ -14,15 +14,32 @@
 
 // READ: https://google.github.io/cpp-proto-builder
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
 #include <filesystem>
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
+#include <utility>
 
 #include "google/protobuf/compiler/importer.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/descriptor_database.h"
 #include "proto_builder/oss/file.h"
 #include "proto_builder/oss/sourcefile_database.h"
+#include "proto_builder/oss/util.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 
 ABSL_FLAG(std::string, protofiles, "",
           ".proto files to load into the default SourceFileDatabase");
@@ -31,13 +48,29 @@ ABSL_FLAG(std::string, proto_paths, "",
           "Comma-separate list of paths to search for proto files. The CWD is "
           "always searched first.");
 
+ABSL_FLAG(std::string, descriptor_set_in, "",
+          "Comma-separated list of serialized FileDescriptorSet files. If set, "
+          "then the proto files are taken from these sets instead of being "
+          "parsed from their sources.");
+
+ABSL_FLAG(bool, descriptor_set_mmap, true,
+          "Whether to memory map the `--descriptor_set_in` files rather than "
+          "reading them.");
+
 ABSL_FLAG(bool, use_global_db, false, "DO NOT USE.");
 
 namespace proto_builder::oss {
 
+using ::google::protobuf::DescriptorDatabase;
+using ::google::protobuf::DescriptorPool;
+using ::google::protobuf::FileDescriptor;
+using ::google::protobuf::FileDescriptorProto;
+using ::google::protobuf::FileDescriptorSet;
+using ::google::protobuf::Message;
+using ::google::protobuf::SimpleDescriptorDatabase;
 using ::google::protobuf::compiler::DiskSourceTree;
-using ::google::protobuf::compiler::Importer;
 using ::google::protobuf::compiler::MultiFileErrorCollector;
+using ::google::protobuf::compiler::SourceTreeDescriptorDatabase;
 
 static auto& sourcefile_database_list =
     *new std::vector<std::unique_ptr<SourceFileDatabase>>;
@@ -60,6 +93,73 @@ class SilentErrorCollector : public MultiFileErrorCollector {
   std::vector<std::string> errors_;
 };
 
+static std::atomic<bool> cache_parsed_files{false};
+
+struct ParsedFile {
+  std::string content;
+  FileDescriptorProto file;
+};
+
+ABSL_CONST_INIT static absl::Mutex parsed_files_mu(absl::kConstInit);
+// Key: virtual file name and disk file name.
+static auto& parsed_files ABSL_GUARDED_BY(parsed_files_mu) =
+    *new std::map<std::pair<std::string, std::string>, ParsedFile>();
+
+// DescriptorDatabase that serves files parsed by `source_database` from a
+// process wide cache, if enabled. Entries are keyed by the virtual and disk
+// file names and are verified against the current content of the disk file.
+class CachingSourceTreeDatabase : public DescriptorDatabase {
+ public:
+  CachingSourceTreeDatabase(DiskSourceTree* source_tree,
+                            DescriptorDatabase* source_database)
+      : source_tree_(source_tree), source_database_(source_database) {}
+
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override {
+    std::string disk_file;
+    if (!cache_parsed_files ||
+        !source_tree_->VirtualFileToDiskFile(filename, &disk_file)) {
+      return source_database_->FindFileByName(filename, output);
+    }
+    auto [status, content] =
+        UnpackStatusOrDefault(file::oss::GetContents(disk_file));
+    if (!status.ok()) {
+      return source_database_->FindFileByName(filename, output);
+    }
+    const std::pair<std::string, std::string> key(filename, disk_file);
+    {
+      absl::MutexLock lock(&parsed_files_mu);
+      auto it = parsed_files.find(key);
+      if (it != parsed_files.end() && it->second.content == content) {
+        *output = it->second.file;
+        return true;
+      }
+    }
+    if (!source_database_->FindFileByName(filename, output)) {
+      return false;
+    }
+    absl::MutexLock lock(&parsed_files_mu);
+    parsed_files[key] = {std::move(content), *output};
+    return true;
+  }
+
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override {
+    return source_database_->FindFileContainingSymbol(symbol_name, output);
+  }
+
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override {
+    return source_database_->FindFileContainingExtension(
+        containing_type, field_number, output);
+  }
+
+ private:
+  DiskSourceTree* const source_tree_;
+  DescriptorDatabase* const source_database_;
+};
+
 class SourceFileDatabaseImpl : public SourceFileDatabase {
  public:
   SourceFileDatabaseImpl(const std::vector<std::string>& proto_files,
@@ -69,7 +169,7 @@ class SourceFileDatabaseImpl : public SourceFileDatabase {
   SourceFileDatabaseImpl(SourceFileDatabaseImpl&&) = default;
   SourceFileDatabaseImpl& operator=(SourceFileDatabaseImpl&&) = default;
 
-  const ::google::protobuf::DescriptorPool* pool() const override { return importer_->pool(); }
+  const ::google::protobuf::DescriptorPool* pool() const override { return pool_.get(); }
 
   bool LoadedSuccessfully() const override { return loaded_successfully_; }
   std::vector<std::string> GetErrors() const override {
@@ -80,12 +180,169 @@ class SourceFileDatabaseImpl : public SourceFileDatabase {
   }
 
  private:
+  // Same as an Importer, but with CachingSourceTreeDatabase in between the
+  // pool and the source tree.
   std::unique_ptr<DiskSourceTree> source_tree_;
   std::unique_ptr<MultiFileErrorCollector> error_collector_;
-  std::unique_ptr<Importer> importer_;
+  std::unique_ptr<SourceTreeDescriptorDatabase> source_database_;
+  std::unique_ptr<CachingSourceTreeDatabase> caching_database_;
+  std::unique_ptr<DescriptorPool> pool_;
   bool loaded_successfully_;
 };
 
+// Collects errors from building the pool of a DescriptorSetDatabaseImpl.
+class PoolErrorCollector : public DescriptorPool::ErrorCollector {
+ public:
+  explicit PoolErrorCollector(std::vector<std::string>* errors)
+      : errors_(errors) {}
+  ~PoolErrorCollector() override = default;
+
+  void AddError(const std::string& filename, const std::string& element_name,
+                const Message* descriptor, ErrorLocation location,
+                const std::string& message) override {
+    errors_->emplace_back(
+        absl::Substitute("$0: $1: $2\n", filename, element_name, message));
+  }
+
+ private:
+  std::vector<std::string>* const errors_;
+};
+
+// Parses the FileDescriptorSet in `file_name` by mapping the file into memory,
+// which avoids copying (large) sets before parsing them.
+bool ParseMappedDescriptorSet(const std::string& file_name,
+                              FileDescriptorSet* output) {
+  int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return false;
+  }
+  const size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    output->Clear();
+    return true;
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  const bool parsed = output->ParseFromArray(data, size);
+  munmap(data, size);
+  return parsed;
+}
+
+bool ParseDescriptorSet(const std::string& file_name, bool use_mmap,
+                        FileDescriptorSet* output) {
+  if (use_mmap) {
+    return ParseMappedDescriptorSet(file_name, output);
+  }
+  std::string content;
+  return file::oss::GetContents(file_name, &content).ok() &&
+         output->ParseFromString(content);
+}
+
+class DescriptorSetDatabaseImpl : public SourceFileDatabase {
+ public:
+  DescriptorSetDatabaseImpl(const std::vector<std::string>& descriptor_sets,
+                            const std::vector<std::string>& proto_files,
+                            const std::vector<std::string>& proto_paths,
+                            bool use_mmap);
+  ~DescriptorSetDatabaseImpl() override = default;
+
+  const ::google::protobuf::DescriptorPool* pool() const override { return pool_.get(); }
+
+  bool LoadedSuccessfully() const override { return loaded_successfully_; }
+  std::vector<std::string> GetErrors() const override { return errors_; }
+
+  // Files in descriptor sets are named by their import path. So in order to
+  // find a file given by its path, that path gets mapped by stripping the
+  // first matching `proto_paths` entry.
+  const FileDescriptor* FindFileByName(
+      const std::string& proto_file) const override;
+
+ private:
+  std::string MapFileName(const std::string& proto_file) const;
+
+  std::vector<std::string> proto_paths_;
+  std::set<std::string> file_names_;
+  std::vector<std::string> errors_;
+  std::unique_ptr<SimpleDescriptorDatabase> database_;
+  std::unique_ptr<PoolErrorCollector> error_collector_;
+  std::unique_ptr<DescriptorPool> pool_;
+  bool loaded_successfully_;
+};
+
+DescriptorSetDatabaseImpl::DescriptorSetDatabaseImpl(
+    const std::vector<std::string>& descriptor_sets,
+    const std::vector<std::string>& proto_files,
+    const std::vector<std::string>& proto_paths, bool use_mmap)
+    : database_(std::make_unique<SimpleDescriptorDatabase>()),
+      error_collector_(std::make_unique<PoolErrorCollector>(&errors_)),
+      pool_(std::make_unique<DescriptorPool>(database_.get(),
+                                             error_collector_.get())),
+      loaded_successfully_(true) {
+  pool_->EnforceWeakDependencies(true);
+  for (const std::string& path : proto_paths) {
+    std::string root(absl::StripSuffix(path, "/"));
+    if (!root.empty() && root != ".") {
+      proto_paths_.push_back(absl::StrCat(root, "/"));
+    }
+  }
+  for (const std::string& descriptor_set : descriptor_sets) {
+    FileDescriptorSet file_set;
+    if (!ParseDescriptorSet(descriptor_set, use_mmap, &file_set)) {
+      errors_.emplace_back(
+          absl::StrCat(descriptor_set, ": Cannot read descriptor set.\n"));
+      loaded_successfully_ = false;
+      continue;
+    }
+    // Sets of dependent libraries share files, only the first one is used.
+    while (!file_set.file().empty()) {
+      std::unique_ptr<FileDescriptorProto> file(
+          file_set.mutable_file()->ReleaseLast());
+      if (file_names_.insert(file->name()).second) {
+        database_->AddAndOwn(file.release());
+      }
+    }
+  }
+  for (const std::string& proto_file : proto_files) {
+    if (FindFileByName(proto_file) == nullptr) {
+      errors_.emplace_back(
+          absl::StrCat(proto_file, ": File not found in descriptor sets.\n"));
+      loaded_successfully_ = false;
+      break;
+    }
+  }
+}
+
+std::string DescriptorSetDatabaseImpl::MapFileName(
+    const std::string& proto_file) const {
+  absl::string_view name = proto_file;
+  absl::ConsumePrefix(&name, "./");
+  if (file_names_.count(std::string(name)) > 0) {
+    return std::string(name);
+  }
+  for (const std::string& path : proto_paths_) {
+    absl::string_view relative = name;
+    if (absl::ConsumePrefix(&relative, path) &&
+        file_names_.count(std::string(relative)) > 0) {
+      return std::string(relative);
+    }
+  }
+  return std::string(name);
+}
+
+const FileDescriptor* DescriptorSetDatabaseImpl::FindFileByName(
+    const std::string& proto_file) const {
+  return pool_->FindFileByName(MapFileName(proto_file));
+}
+
 /*static*/
 std::unique_ptr<SourceFileDatabase> SourceFileDatabase::New(
     const std::vector<std::string>& proto_files,
@@ -109,14 +366,43 @@ std::vector<std::string> SourceFileDatabase::GetProtoPathsFlag() {
                         absl::SkipEmpty());
 }
 
+/*static*/
+std::unique_ptr<SourceFileDatabase> SourceFileDatabase::NewFromDescriptorSets(
+    const std::vector<std::string>& descriptor_sets,
+    const std::vector<std::string>& proto_files,
+    const std::vector<std::string>& proto_paths, bool use_mmap) {
+  return std::make_unique<DescriptorSetDatabaseImpl>(
+      descriptor_sets, proto_files, proto_paths, use_mmap);
+}
+
+std::vector<std::string> SourceFileDatabase::GetDescriptorSetInFlag() {
+  return absl::StrSplit(absl::GetFlag(FLAGS_descriptor_set_in), ',',
+                        absl::SkipEmpty());
+}
+
+bool SourceFileDatabase::GetDescriptorSetMmapFlag() {
+  return absl::GetFlag(FLAGS_descriptor_set_mmap);
+}
+
+void SourceFileDatabase::SetCacheParsedFiles(bool enable) {
+  cache_parsed_files = enable;
+}
+
 SourceFileDatabaseImpl::SourceFileDatabaseImpl(
     const std::vector<std::string>& proto_files,
     const std::vector<std::string>& proto_paths)
     : source_tree_(std::make_unique<DiskSourceTree>()),
       error_collector_(std::make_unique<SilentErrorCollector>()),
-      importer_(std::make_unique<Importer>(source_tree_.get(),
-                                           error_collector_.get())),
+      source_database_(
+          std::make_unique<SourceTreeDescriptorDatabase>(source_tree_.get())),
+      caching_database_(std::make_unique<CachingSourceTreeDatabase>(
+          source_tree_.get(), source_database_.get())),
+      pool_(std::make_unique<DescriptorPool>(
+          caching_database_.get(),
+          source_database_->GetValidationErrorCollector())),
       loaded_successfully_(true) {
+  pool_->EnforceWeakDependencies(true);
+  source_database_->RecordErrorsTo(error_collector_.get());
   std::string root_path = std::filesystem::current_path().root_path().string();
   source_tree_->MapPath("", ".");
   for (const std::string& path : proto_paths) {
@@ -124,7 +410,7 @@ SourceFileDatabaseImpl::SourceFileDatabaseImpl(
   }
   source_tree_->MapPath(root_path, root_path);
   for (const std::string& proto_file : proto_files) {
-    if (importer_->Import(proto_file) == nullptr) {
+    if (pool_->FindFileByName(proto_file) == nullptr) {
       loaded_successfully_ = false;
       break;
     }
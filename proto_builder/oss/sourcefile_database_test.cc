@@ -44,6 +44,12 @@ class SourceFileDatabaseTest : public ::testing::Test {
     return relative ? filename : JoinPath(GetRunfilesDir(), filename);
   }
 
+  static std::string GetDescriptorSet() {
+    return JoinPath(GetRunfilesDir(),
+                    "proto_builder/oss/tests/"
+                    "simple_message_proto-descriptor-set.proto.bin");
+  }
+
   static std::string GetBadFile(bool relative = false) {
     const std::string filename =
         "proto_builder/oss/tests/"
@@ -107,5 +113,51 @@ TEST_F(SourceFileDatabaseTest, LoadError) {
   EXPECT_THAT(sfdb->GetErrors(), Contains(HasSubstr(GetBadFile(true))));
 }
 
+TEST_F(SourceFileDatabaseTest, NewFromDescriptorSets) {
+  for (bool use_mmap : {false, true}) {
+    // The set is listed twice to verify files are only loaded once.
+    std::unique_ptr<SourceFileDatabase> sfdb(
+        SourceFileDatabase::NewFromDescriptorSets(
+            {GetDescriptorSet(), GetDescriptorSet()}, {GetFile(true)}, {},
+            use_mmap));
+    ASSERT_THAT(sfdb, NotNull());
+    ASSERT_THAT(sfdb->pool(), NotNull());
+    EXPECT_TRUE(sfdb->LoadedSuccessfully());
+    EXPECT_THAT(sfdb->GetErrors(), IsEmpty());
+    EXPECT_THAT(sfdb->FindFileByName(GetFile(true)), NotNull());
+    EXPECT_THAT(sfdb->pool()->FindMessageTypeByName(
+                    "proto_builder.oss.SimpleMessage"),
+                NotNull());
+  }
+}
+
+TEST_F(SourceFileDatabaseTest, NewFromDescriptorSetsMapsProtoPaths) {
+  std::unique_ptr<SourceFileDatabase> sfdb(
+      SourceFileDatabase::NewFromDescriptorSets(
+          {GetDescriptorSet()}, {JoinPath("some/root", GetFile(true))},
+          {"some/root/"}));
+  ASSERT_THAT(sfdb, NotNull());
+  EXPECT_TRUE(sfdb->LoadedSuccessfully());
+  EXPECT_THAT(sfdb->FindFileByName(JoinPath("some/root", GetFile(true))),
+              NotNull());
+  EXPECT_THAT(sfdb->FindFileByName(GetFile(true)), NotNull());
+  EXPECT_THAT(sfdb->FindFileByName("other/root/does_not_exist.proto"),
+              IsNull());
+}
+
+TEST_F(SourceFileDatabaseTest, NewFromDescriptorSetsErrors) {
+  std::unique_ptr<SourceFileDatabase> sfdb(
+      SourceFileDatabase::NewFromDescriptorSets({GetDescriptorSet()},
+                                                {"does_not_exist.proto"}, {}));
+  ASSERT_THAT(sfdb, NotNull());
+  EXPECT_FALSE(sfdb->LoadedSuccessfully());
+  EXPECT_THAT(sfdb->GetErrors(), Contains(HasSubstr("does_not_exist.proto")));
+  sfdb = SourceFileDatabase::NewFromDescriptorSets({GetBadFile()},
+                                                   {GetFile(true)}, {});
+  ASSERT_THAT(sfdb, NotNull());
+  EXPECT_FALSE(sfdb->LoadedSuccessfully());
+  EXPECT_THAT(sfdb->GetErrors(), Contains(HasSubstr(GetBadFile())));
+}
+
 }  // namespace
 }  // namespace proto_builder::oss
@@ -14,187 +14,621 @@
 
 #include "proto_builder/oss/template_dictionary.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "proto_builder/oss/logging.h"
-#include "absl/strings/match.h"
+#include "absl/algorithm/container.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
-#include "re2/re2.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
 
 namespace proto_builder::oss {
+namespace {
 
-using RegExpStringPiece = ::re2::StringPiece;
+bool IsBlank(char c) { return c == ' ' || c == '\t'; }
 
-static auto& g_template_cache = *new std::map<std::string, std::string>;
+bool IsNewLine(char c) { return c == '\n' || c == '\r'; }
 
-template <class DataType>
-TemplateDictionary::TagInfo<DataType>::TagInfo(absl::string_view tag,
-                                               DataType data)
-    : tag(absl::StrCat("{{", tag, "}}")),
-      tag_start(absl::StrCat("{{#", tag, "}}")),
-      tag_end(absl::StrCat("{{/", tag, "}}")),
-      data(std::move(data)) {}
-
-TemplateDictionary* TemplateDictionary::AddSectionDictionary(
-    absl::string_view name) {
-  auto [it, inserted] =
-      data_.emplace(name, TagInfo<SectionDictionary>(name, {}));
-  auto& dict = absl::get<TagInfo<SectionDictionary>>(it->second).data;
-  return &dict.emplace_back(TemplateDictionary(name));
+// Section tags must use word names (`\w+`), everything else is a simple tag.
+bool IsSectionName(absl::string_view name) {
+  return !name.empty() && absl::c_all_of(name, [](char c) {
+    return absl::ascii_isalnum(c) || c == '_';
+  });
 }
 
-void TemplateDictionary::SetValue(absl::string_view name,
-                                  absl::string_view value) {
-  auto [it, inserted] =
-      data_.emplace(name, TagInfo<std::string>(name, std::string(value)));
-  QCHECK(inserted);
-}
+// A compiled template is a tree of nodes whose `text` points into the source.
+struct TemplateNode {
+  enum Kind {
+    kText,      // Literal text.
+    kValue,     // {{NAME}}
+    kSection,   // {{#NAME}}...{{/NAME}} with the content in `body`.
+    kStrayEnd,  // {{/NAME}} without a start tag.
+    kError,     // Section {{#NAME}} without (proper) end tag.
+  };
 
-bool TemplateDictionary::ExpandTemplate(absl::string_view name,
-                                        std::string* output) const {
-  auto it = g_template_cache.find(std::string(name));
-  if (it == g_template_cache.end()) {
-    output->clear();
-    return false;
+  TemplateNode(Kind kind, absl::string_view text) : kind(kind), text(text) {}
+
+  Kind kind;
+  absl::string_view text;  // The literal text or the tag name.
+  // For kSection: the start/end tag is directly followed by a new-line.
+  bool newline_follows = false;
+  bool end_newline_follows = false;
+  std::vector<TemplateNode> body;
+};
+
+using TemplateNodes = std::vector<TemplateNode>;
+
+// Parses `source` into a tree of nodes.
+//
+// Tags that are the only thing on their line get removed together with the
+// line if they expand to nothing. Whether that is the case depends on the
+// dictionary, so it is decided during expansion.
+class TemplateParser {
+ public:
+  explicit TemplateParser(absl::string_view source) : source_(source) {}
+
+  TemplateNodes Parse() && {
+    size_t pos = 0;
+    while ((pos = source_.find("{{", pos)) != absl::string_view::npos) {
+      const size_t close = source_.find("}}", pos + 2);
+      if (close == absl::string_view::npos) {
+        break;
+      }
+      absl::string_view tag = source_.substr(pos + 2, close - pos - 2);
+      if (tag.find_first_of("{}\n\r") != absl::string_view::npos) {
+        ++pos;  // Not a tag, but a tag may start at the next brace.
+        continue;
+      }
+      AddText(pos);
+      text_start_ = close + 2;
+      if (tag.size() > 1 && tag[0] == '#' && IsSectionName(tag.substr(1))) {
+        StartSection(tag.substr(1), text_start_);
+      } else if (tag.size() > 1 && tag[0] == '/' &&
+                 IsSectionName(tag.substr(1))) {
+        EndSection(tag.substr(1));
+      } else {
+        stack_.back().nodes.emplace_back(TemplateNode::kValue, tag);
+      }
+      pos = close + 2;
+    }
+    AddText(source_.size());
+    while (stack_.size() > 1) {
+      PopUnmatched();
+    }
+    return std::move(stack_.front().nodes);
   }
-  *output = it->second;
-  return Expand(output);
-}
 
-std::pair<size_t, size_t> FindTag(const std::string& output,
-                                  const std::string& tag) {
-  const size_t tag_pos = output.find(tag);
-  if (tag_pos == std::string::npos) {
-    return {tag_pos, 0};
-  }
-  size_t end = tag_pos + tag.length();
-  // Is the tag followed by a new-line?
-  if (end < output.size() && (output[end] == '\n' || output[end] == '\r')) {
-    ++end;
-    size_t pos = tag_pos;
-    // reverse past all space
-    while (pos > 0 && (output[pos - 1] == ' ' || output[pos - 1] == '\t')) {
-      --pos;
+ private:
+  struct Frame {
+    absl::string_view name;
+    bool newline_follows = false;
+    bool valid = true;
+    TemplateNodes nodes;
+  };
+
+  bool NewLineAt(size_t pos) const {
+    return pos < source_.size() && IsNewLine(source_[pos]);
+  }
+
+  void AddText(size_t end) {
+    if (end > text_start_) {
+      stack_.back().nodes.emplace_back(
+          TemplateNode::kText, source_.substr(text_start_, end - text_start_));
     }
-    if (pos == 0 || output[pos - 1] == '\n' || output[pos - 1] == '\r') {
-      // Only preceded by whitespace and followed directly by a new-line.
-      return {pos, tag_pos - pos + tag.length() + 1};
+  }
+
+  void StartSection(absl::string_view name, size_t end) {
+    for (Frame& frame : stack_) {
+      if (frame.name == name) {
+        frame.valid = false;  // Sections cannot be nested in themselves.
+      }
     }
+    Frame& frame = stack_.emplace_back();
+    frame.name = name;
+    frame.newline_follows = NewLineAt(end);
   }
-  return {tag_pos, tag.length()};
-}
 
-// static
-bool TemplateDictionary::RemoveTags(std::string* value) {
-  static LazyRE2 kStartTags = {"{{#(\\w+)}}"};
-  RegExpStringPiece pos = *value;
-  RegExpStringPiece name;
-  std::vector<std::string> names;
-  while (RE2::FindAndConsume(&pos, *kStartTags, &name)) {
-    names.emplace_back(name);
-  }
-  for (const std::string& name : names) {
-    const std::string simple = absl::StrCat("{{", name, "}}");
-    if (absl::StrContains(*value, simple)) {
-      QLOG(ERROR) << "Section tag '" << name << "' also used as simple tag.";
-      return false;
+  void EndSection(absl::string_view name) {
+    size_t index = stack_.size() - 1;
+    while (index > 0 && stack_[index].name != name) {
+      --index;
     }
-    const std::string start = absl::StrCat("{{#", name, "}}");
-    const std::string end = absl::StrCat("{{/", name, "}}");
-    while (true) {
-      const auto [pos_start, start_len] = FindTag(*value, start);
-      const auto [pos_end, end_len] = FindTag(*value, end);
-      if (pos_start == std::string::npos) {
-        if (pos_end != std::string::npos) {
-          QLOG(ERROR) << "Section '" << name << "' has no matching end tag.";
-          return false;
-        }
-        break;
+    if (index == 0) {
+      stack_.back().nodes.emplace_back(TemplateNode::kStrayEnd, name);
+      return;
+    }
+    while (index + 1 < stack_.size()) {
+      PopUnmatched();
+    }
+    Frame frame = std::move(stack_.back());
+    stack_.pop_back();
+    if (frame.valid) {
+      TemplateNode& node =
+          stack_.back().nodes.emplace_back(TemplateNode::kSection, name);
+      node.newline_follows = frame.newline_follows;
+      node.end_newline_follows = NewLineAt(text_start_);
+      node.body = std::move(frame.nodes);
+    } else {
+      stack_.back().nodes.emplace_back(TemplateNode::kError, name);
+    }
+  }
+
+  void PopUnmatched() {
+    const absl::string_view name = stack_.back().name;
+    stack_.pop_back();
+    stack_.back().nodes.emplace_back(TemplateNode::kError, name);
+  }
+
+  const absl::string_view source_;
+  size_t text_start_ = 0;
+  std::vector<Frame> stack_ = std::vector<Frame>(1);
+};
+
+// A template source together with its compiled form.
+class CompiledTemplate {
+ public:
+  explicit CompiledTemplate(std::string source)
+      : source_(std::move(source)), nodes_(TemplateParser(source_).Parse()) {}
+
+  CompiledTemplate(const CompiledTemplate&) = delete;
+  CompiledTemplate& operator=(const CompiledTemplate&) = delete;
+
+  const std::string& source() const { return source_; }
+  const TemplateNodes& nodes() const { return nodes_; }
+
+ private:
+  const std::string source_;
+  const TemplateNodes nodes_;
+};
+
+auto& g_template_cache = *new std::map<
+    std::string, std::unique_ptr<const CompiledTemplate>, std::less<>>;
+
+// Expands a compiled template in a single pass into an output string.
+//
+// The expansion reproduces the original string rewriting implementation which
+// replaced one name after the other (in name order) and expanded sections by
+// copying their content once per section dictionary. In that model the values
+// of a parent dictionary whose names sort before the section name are replaced
+// before the section is copied, all others after it was expanded. That order
+// decides which dictionary provides a value and whether an empty value or a
+// section start tag is the only thing on its line. Values that contain tags
+// are expanded with the names that would have been replaced after them.
+class TemplateExpander {
+ public:
+  explicit TemplateExpander(std::string* output) : output_(*output) {}
+
+  bool Expand(const TemplateDictionary& dict, const TemplateNodes& nodes) {
+    return ExpandNodes({nodes}, Scope(dict), false, {});
+  }
+
+ private:
+  using Data = TemplateDictionary::Data;
+  using SectionDictionary = TemplateDictionary::SectionDictionary;
+
+  // When a tag was processed in the string rewriting model.
+  struct Order {
+    int phase;  // 0: Parent before section, 1: Own, 2: Parent after section.
+    int level;
+    absl::string_view name;
+
+    bool operator<(const Order& other) const {
+      return std::tie(phase, level, name) <
+             std::tie(other.phase, other.level, other.name);
+    }
+  };
+
+  // Unknown sections are removed after all own values were replaced.
+  static constexpr Order kRemoveOrder = {.phase = 1, .level = 1, .name = {}};
+
+  struct Scope {
+    explicit Scope(const TemplateDictionary& dict) : dict(dict) {}
+    Scope(const TemplateDictionary& dict, const Scope* parent,
+          absl::string_view section, size_t start)
+        : dict(dict),
+          parent(parent),
+          section(section),
+          depth(parent->depth + 1),
+          start(start) {}
+
+    const TemplateDictionary& dict;
+    const Scope* parent = nullptr;
+    absl::string_view section;  // The section that leads from `parent`.
+    int depth = 0;
+    size_t start = 0;  // Output position at which the expansion started.
+    // Expanding a value: Only names after `after` are visible in `dict`.
+    bool in_value = false;
+    absl::string_view after;
+  };
+
+  struct Match {
+    const Data* data = nullptr;
+    const Scope* scope = nullptr;
+    Order order = {};
+  };
+
+  struct LineTag {
+    Order order;
+    size_t pos;
+  };
+
+  // The tags written on the output line that starts at `line_start`.
+  struct LineTags {
+    size_t line_start = 0;
+    std::vector<LineTag> tags;
+  };
+
+  // The part of a section body to expand.
+  struct Body {
+    absl::Span<const TemplateNode> nodes;
+    size_t last_text_size = std::string::npos;  // Truncates the last node.
+  };
+
+  static bool Accept(const Data* data, bool section) {
+    return data != nullptr &&
+           (!section || absl::holds_alternative<SectionDictionary>(*data));
+  }
+
+  // Finds `name` in parents that replace it before copying section `scope`.
+  static Match FindBefore(absl::string_view name, const Scope& scope,
+                          bool section) {
+    if (scope.parent == nullptr) {
+      return {};
+    }
+    if (Match match = FindBefore(name, *scope.parent, section); match.data) {
+      return match;
+    }
+    if (name < scope.section) {
+      if (const Data* data = scope.parent->dict.Find(name);
+          Accept(data, section)) {
+        return {data, scope.parent, {0, scope.parent->depth, name}};
       }
-      if (pos_end == std::string::npos) {
-        QLOG(ERROR) << "Section '" << name << "' has start but no end marker.";
-        return false;
+    }
+    return {};
+  }
+
+  static Match Lookup(absl::string_view name, const Scope& scope,
+                      bool section) {
+    if (!scope.in_value) {
+      if (Match match = FindBefore(name, scope, section); match.data) {
+        return match;
       }
-      if (pos_start > pos_end) {
-        QLOG(ERROR) << "Section '" << name << "' has end before start marker.";
-        return false;
+    }
+    if (!scope.in_value || name > scope.after) {
+      if (const Data* data = scope.dict.Find(name); Accept(data, section)) {
+        return {data, &scope, {1, 0, name}};
       }
-      size_t len = pos_end - pos_start + end_len;
-      value->replace(pos_start, len, "");
     }
+    if (section) {
+      return {};  // Unknown sections get removed by their own dictionary.
+    }
+    for (const Scope* s = &scope; s->parent != nullptr; s = s->parent) {
+      if (name >= s->section) {
+        if (const Data* data = s->parent->dict.Find(name); data != nullptr) {
+          return {data, s->parent, {2, -s->parent->depth, name}};
+        }
+      }
+    }
+    return {};
   }
-  return true;
-}
 
-bool TemplateDictionary::Expand(std::string* output) const {
-  for (const auto& [name, data] : data_) {
-    if (!absl::visit([&](const auto& d) { return Expand(d, output); }, data)) {
-      return false;
+  // Returns the start of the current line if it only contains blanks, but
+  // not before `floor`.
+  size_t BlankLineStart(size_t floor) const {
+    floor = std::min(floor, output_.size());
+    size_t pos = output_.size();
+    while (pos > floor && IsBlank(output_[pos - 1])) {
+      --pos;
     }
+    if (pos == floor || IsNewLine(output_[pos - 1])) {
+      return pos;
+    }
+    return std::string::npos;
+  }
+
+  // Returns the start of the last output line. Only output written since the
+  // previous call is scanned.
+  size_t LineStart() {
+    for (size_t pos = output_.size(); pos > scanned_; --pos) {
+      if (IsNewLine(output_[pos - 1])) {
+        line_start_ = pos;
+        break;
+      }
+    }
+    scanned_ = output_.size();
+    return line_start_;
+  }
+
+  // Output only gets truncated within its last line, so the known line start
+  // stays valid.
+  void TruncateOutput(size_t size) {
+    output_.resize(size);
+    scanned_ = std::min(scanned_, size);
+  }
+
+  // Records a tag processed at `order` that was written at `pos`. Tags of
+  // previous lines are dropped.
+  void AddLineTag(const Order& order, size_t pos, LineTags* line_tags) {
+    const size_t line_start = LineStart();
+    if (line_tags->line_start != line_start) {
+      line_tags->line_start = line_start;
+      line_tags->tags.clear();
+    }
+    line_tags->tags.push_back({order, pos});
+  }
+
+  // Whether a tag processed after `order` was written since `line_start`,
+  // which must be on the last output line.
+  bool LaterTagOnLine(size_t line_start, const Order& order,
+                      const LineTags& line_tags) {
+    if (line_tags.line_start != LineStart()) {
+      return false;  // All tags were written on previous lines.
+    }
+    return absl::c_any_of(line_tags.tags, [&](const LineTag& tag) {
+      return tag.pos >= line_start && order < tag.order;
+    });
+  }
+
+  // Whether value tag `node` was removed before `order` was processed.
+  static bool RemovedBefore(const TemplateNode& node, const Scope& scope,
+                            const Order& order) {
+    const Match match = Lookup(node.text, scope, false);
+    const std::string* value =
+        match.data ? absl::get_if<std::string>(match.data) : nullptr;
+    return value != nullptr && value->empty() && match.order < order;
   }
-  return RemoveTags(output);
-}
 
-bool TemplateDictionary::Expand(const TagInfo<SectionDictionary>& tag,
-                                std::string* output) const {
-  if (absl::StrContains(*output, tag.tag)) {
-    QLOG(ERROR) << "Simple tag '" << tag.tag << "' used in SectionDictionary.";
+  // Whether node `index` is followed by a new-line, ignoring empty values that
+  // were removed before `order`.
+  static bool NewLineFollows(absl::Span<const TemplateNode> nodes,
+                             size_t index, const Order& order,
+                             const Scope& scope) {
+    for (size_t next = index + 1; next < nodes.size(); ++next) {
+      const TemplateNode& node = nodes[next];
+      if (node.kind == TemplateNode::kText) {
+        return IsNewLine(node.text.front());
+      }
+      if (node.kind != TemplateNode::kValue ||
+          !RemovedBefore(node, scope, order)) {
+        return false;
+      }
+    }
     return false;
   }
-  while (true) {
-    const auto [pos_start, start_len] = FindTag(*output, tag.tag_start);
-    const auto [pos_end, end_len] = FindTag(*output, tag.tag_end);
-    if (pos_start == std::string::npos) {
-      // Presence is not required.
-      // But end without start is bad.
-      if (pos_end != std::string::npos) {
+
+  // Whether the end tag of section `node` is the only thing on its line when
+  // `order` is processed. If so `body` is set to the body without that line.
+  static bool EndAlone(const TemplateNode& node, const Order& order,
+                       const Scope& scope, Body* body) {
+    if (!node.end_newline_follows) {
+      return false;
+    }
+    for (size_t index = node.body.size(); index > 0; --index) {
+      const TemplateNode& last = node.body[index - 1];
+      if (last.kind == TemplateNode::kText) {
+        const size_t newline = last.text.find_last_of("\n\r");
+        const absl::string_view tail = newline == absl::string_view::npos
+                                           ? last.text
+                                           : last.text.substr(newline + 1);
+        if (!absl::c_all_of(tail, IsBlank)) {
+          return false;
+        }
+        if (newline != absl::string_view::npos) {
+          body->nodes = absl::MakeConstSpan(node.body).first(index);
+          body->last_text_size = newline + 1;
+          return true;
+        }
+      } else if (last.kind != TemplateNode::kValue ||
+                 !RemovedBefore(last, scope, order)) {
         return false;
       }
-      break;
     }
-    if (pos_end == std::string::npos || pos_end < pos_start) {
+    return false;  // Preceded by the start tag.
+  }
+
+  bool ExpandValue(absl::Span<const TemplateNode> nodes, size_t index,
+                   const Scope& scope, LineTags* line_tags,
+                   bool* skip_newline) {
+    const absl::string_view name = nodes[index].text;
+    const size_t pos = output_.size();
+    const Match match = Lookup(name, scope, false);
+    if (match.data == nullptr) {
+      absl::StrAppend(&output_, "{{", name, "}}");
+      literals_.push_back(name);
+      return true;
+    }
+    const std::string* value = absl::get_if<std::string>(match.data);
+    if (value == nullptr) {
+      QLOG(ERROR) << "Simple tag '{{" << name << "}}' used in SectionDictionary.";
       return false;
     }
-    const size_t tmpl_len = pos_end - pos_start - start_len;
-    size_t pos_insert = pos_end + end_len;
-    for (const auto& section : tag.data) {
-      // Fetch the template (each time) into a new string.
-      std::string value = output->substr(pos_start + start_len, tmpl_len);
-      if (!section.Expand(&value)) {
+    if (value->empty()) {
+      const size_t line_start = BlankLineStart(match.scope->start);
+      if (line_start != std::string::npos &&
+          !LaterTagOnLine(line_start, match.order, *line_tags) &&
+          NewLineFollows(nodes, index, match.order, scope)) {
+        TruncateOutput(line_start);
+        *skip_newline = true;
+        return true;  // The line is gone, so is the tag.
+      }
+    } else if (value->find("{{") == std::string::npos) {
+      output_.append(*value);
+    } else {
+      Scope value_scope = *match.scope;
+      value_scope.in_value = true;
+      value_scope.after = name;
+      const TemplateNodes value_nodes = TemplateParser(*value).Parse();
+      if (!ExpandNodes({value_nodes}, value_scope, false, {})) {
         return false;
       }
-      output->insert(pos_insert, value);
-      pos_insert += value.length();
     }
-    // Now remove the template as it is no longer needed.
-    output->replace(pos_start, tmpl_len + start_len + end_len, "");
+    AddLineTag(match.order, pos, line_tags);
+    return true;
   }
-  return true;
-}
 
-bool TemplateDictionary::Expand(const TagInfo<std::string>& tag,
-                                std::string* output) const {
-  if (tag.data.empty()) {
-    while (true) {
-      const auto [pos, len] = FindTag(*output, tag.tag);
-      if (!len) {
-        break;
+  bool ExpandSection(const TemplateNode& node, const Scope& scope,
+                     LineTags* line_tags,
+                     std::vector<absl::string_view>* removed,
+                     bool* skip_newline) {
+    const Match match = Lookup(node.text, scope, true);
+    const Scope& owner = match.data ? *match.scope : scope;
+    const Order order = match.data ? match.order : kRemoveOrder;
+    bool alone = false;
+    if (node.newline_follows) {
+      const size_t line_start = BlankLineStart(owner.start);
+      if (line_start != std::string::npos &&
+          !LaterTagOnLine(line_start, order, *line_tags)) {
+        TruncateOutput(line_start);
+        alone = true;
+      }
+    }
+    Body body = {.nodes = node.body};
+    const bool end_alone = EndAlone(node, order, scope, &body);
+    // Tags that are not alone on their line stay on the line until processed.
+    if (!alone) {
+      AddLineTag(order, output_.size(), line_tags);
+    }
+    if (match.data == nullptr) {
+      removed->push_back(node.text);
+    } else {
+      for (const TemplateDictionary& dict :
+           absl::get<SectionDictionary>(*match.data)) {
+        // A start tag that is not alone stays on the first line until the
+        // section gets processed.
+        const Scope child(dict, &owner, node.text, output_.size());
+        LineTags child_tags;
+        if (!alone) {
+          AddLineTag({0, owner.depth, node.text}, child.start, &child_tags);
+        }
+        if (!ExpandNodes(body, child, alone, std::move(child_tags))) {
+          return false;
+        }
       }
-      output->erase(pos, len);
     }
-  } else {
-    absl::StrReplaceAll({{tag.tag, tag.data}}, output);
+    if (end_alone) {
+      *skip_newline = true;
+    } else {
+      AddLineTag(order, output_.size(), line_tags);
+    }
+    return true;
   }
 
-  return true;
+  bool ExpandNodes(const Body& body, const Scope& scope, bool skip_newline,
+                   LineTags line_tags) {
+    const absl::Span<const TemplateNode> nodes = body.nodes;
+    const size_t first_literal = literals_.size();
+    std::vector<absl::string_view> removed;
+    for (size_t index = 0; index < nodes.size(); ++index) {
+      const TemplateNode& node = nodes[index];
+      switch (node.kind) {
+        case TemplateNode::kText: {
+          absl::string_view text = node.text;
+          if (index + 1 == nodes.size()) {
+            text = text.substr(0, body.last_text_size);
+          }
+          if (skip_newline) {
+            text.remove_prefix(1);
+            skip_newline = false;
+          }
+          output_.append(text.data(), text.size());
+          break;
+        }
+        case TemplateNode::kValue:
+          if (!ExpandValue(nodes, index, scope, &line_tags, &skip_newline)) {
+            return false;
+          }
+          break;
+        case TemplateNode::kSection:
+          if (!ExpandSection(node, scope, &line_tags, &removed,
+                             &skip_newline)) {
+            return false;
+          }
+          break;
+        case TemplateNode::kStrayEnd:
+          if (Lookup(node.text, scope, true).data != nullptr) {
+            QLOG(ERROR) << "Section '" << node.text
+                        << "' has end before start marker.";
+            return false;
+          }
+          absl::StrAppend(&output_, "{{/", node.text, "}}");
+          break;
+        case TemplateNode::kError:
+          QLOG(ERROR) << "Section '" << node.text
+                      << "' has start but no end marker.";
+          return false;
+      }
+    }
+    if (!scope.in_value) {
+      for (const absl::string_view name : removed) {
+        if (std::find(literals_.begin() + first_literal, literals_.end(),
+                      name) != literals_.end()) {
+          QLOG(ERROR) << "Section tag '" << name << "' also used as simple tag.";
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  std::string& output_;
+  size_t scanned_ = 0;     // Output size up to which `line_start_` is known.
+  size_t line_start_ = 0;  // Start of the last line in `output_[0, scanned_)`.
+  std::vector<absl::string_view> literals_;  // Unknown simple tags written.
+};
+
+}  // namespace
+
+TemplateDictionary* TemplateDictionary::AddSectionDictionary(
+    absl::string_view name) {
+  auto [it, inserted] = data_.emplace(name, SectionDictionary());
+  return &absl::get<SectionDictionary>(it->second).emplace_back(name);
+}
+
+void TemplateDictionary::SetValue(absl::string_view name,
+                                  absl::string_view value) {
+  auto [it, inserted] = data_.emplace(name, std::string(value));
+  QCHECK(inserted);
+}
+
+const TemplateDictionary::Data* TemplateDictionary::Find(
+    absl::string_view name) const {
+  const auto it = data_.find(name);
+  return it == data_.end() ? nullptr : &it->second;
+}
+
+bool TemplateDictionary::Expand(std::string* output) const {
+  const CompiledTemplate tpl(std::move(*output));
+  output->clear();
+  return TemplateExpander(output).Expand(*this, tpl.nodes());
+}
+
+bool TemplateDictionary::ExpandTemplate(absl::string_view name,
+                                        std::string* output) const {
+  output->clear();
+  const auto it = g_template_cache.find(name);
+  if (it == g_template_cache.end()) {
+    return false;
+  }
+  return TemplateExpander(output).Expand(*this, it->second->nodes());
 }
 
 bool StringToTemplateCache(absl::string_view name, absl::string_view tpl,
                            DoNotStrip do_not_strip) {
-  return g_template_cache.emplace(name, tpl).second;
+  const auto it = g_template_cache.find(name);
+  if (it != g_template_cache.end()) {
+    return it->second->source() == tpl;
+  }
+  g_template_cache.emplace(
+      name, std::make_unique<const CompiledTemplate>(std::string(tpl)));
+  return true;
 }
 
 bool ExpandTemplate(absl::string_view name, DoNotStrip do_not_strip,
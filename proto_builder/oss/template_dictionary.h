@@ -15,6 +15,7 @@
 #ifndef PROTO_BUILDER_OSS_TEMPLATE_DICTIONARY_H_
 #define PROTO_BUILDER_OSS_TEMPLATE_DICTIONARY_H_
 
+#include <functional>
 #include <list>
 #include <map>
 #include <string>
@@ -26,43 +27,44 @@ namespace proto_builder::oss {
 
 enum DoNotStrip { DO_NOT_STRIP = 0 };
 
+// Templates use `{{NAME}}` for values and `{{#NAME}}...{{/NAME}}` for sections
+// that get expanded once per section dictionary. Templates are compiled once
+// (see `StringToTemplateCache`) and then expanded in a single pass.
+//
+// Values are looked up in the dictionary and its parents, unknown values are
+// kept as is and unknown sections are removed. A value or section tag that is
+// the only thing on its line is removed together with the line if it expands
+// to nothing.
 class TemplateDictionary {
  public:
+  using SectionDictionary = std::list<TemplateDictionary>;
+
+  // Type `Data` holds all possible information variants.
+  using Data = absl::variant<SectionDictionary, std::string>;
+
   explicit TemplateDictionary(absl::string_view name) : name_(name) {}
 
   TemplateDictionary* AddSectionDictionary(absl::string_view name);
   void SetValue(absl::string_view name, absl::string_view value);
 
+  // Expands the template given in `output` and replaces it with the result.
   bool Expand(std::string* output) const;
   bool ExpandTemplate(absl::string_view name, std::string* output) const;
 
   std::string name() const { return name_; }
 
- private:
-  using SectionDictionary = std::list<TemplateDictionary>;
-
-  template <class DataType>
-  struct TagInfo {
-    TagInfo(absl::string_view tag, DataType data);
-    const std::string tag;
-    const std::string tag_start;
-    const std::string tag_end;
-    DataType data;
-  };
-
-  // Type `Data` holds all possible information variants. Each of these needs
-  // to have a matching `Expand(const TagInfo<Data-Type>&, std::string*)`.
-  using Data = absl::variant<TagInfo<SectionDictionary>, TagInfo<std::string>>;
-
-  static bool RemoveTags(std::string* value);
-
-  bool Expand(const TagInfo<SectionDictionary>& tag, std::string* output) const;
-  bool Expand(const TagInfo<std::string>& tag, std::string* output) const;
+  // Returns the value or section dictionaries set under `name` in this
+  // dictionary (parents are not searched), or nullptr if there is none.
+  const Data* Find(absl::string_view name) const;
 
+ private:
   const std::string name_;
-  std::map<std::string, Data> data_;
+  std::map<std::string, Data, std::less<>> data_;
 };
 
+// Adds `tpl` under `name` to the template cache. Returns false if a different
+// template was already registered under `name`. Registering the identical
+// template again succeeds, so templates can be loaded repeatedly.
 bool StringToTemplateCache(absl::string_view name, absl::string_view tpl,
                            DoNotStrip do_not_strip);
 bool ExpandTemplate(absl::string_view name, DoNotStrip do_not_strip,
@@ -228,5 +228,155 @@ TEST_F(TemplateDictionaryTest, DictWhitespace) {
   }
 }
 
+TEST_F(TemplateDictionaryTest, NotATag) {
+  const absl::string_view tmpl = "{{a\n}} {{a}} {{{a} {{a";
+  TemplateDictionary dict("blabla");
+  dict.SetValue("a", "A");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "{{a\n}} A {{{a} {{a"));
+}
+
+TEST_F(TemplateDictionaryTest, NestedSections) {
+  const absl::string_view tmpl =
+      "{{#outer}}[{{#inner}}({{x}}){{/inner}}]{{/outer}}";
+  TemplateDictionary dict("blabla");
+  TemplateDictionary* first = dict.AddSectionDictionary("outer");
+  first->AddSectionDictionary("inner")->SetValue("x", "1");
+  first->AddSectionDictionary("inner")->SetValue("x", "2");
+  dict.AddSectionDictionary("outer");
+  dict.AddSectionDictionary("outer")->AddSectionDictionary("inner");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "[(1)(2)][][({{x}})]"));
+}
+
+TEST_F(TemplateDictionaryTest, NestedSectionNotPresent) {
+  const absl::string_view tmpl =
+      "{{#outer}}<{{#missing}}{{x}}{{/missing}}>{{/outer}}";
+  TemplateDictionary dict("blabla");
+  dict.AddSectionDictionary("outer")->SetValue("x", "X");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "<>"));
+}
+
+TEST_F(TemplateDictionaryTest, SectionNestedInItself) {
+  const absl::string_view tmpl = "{{#dict}}{{#dict}}{{/dict}}{{/dict}}";
+  TemplateDictionary dict("blabla");
+  dict.AddSectionDictionary("dict");
+  EXPECT_THAT(Expand(dict, tmpl), Key(false));
+}
+
+TEST_F(TemplateDictionaryTest, SectionWithoutEnd) {
+  TemplateDictionary dict("blabla");
+  EXPECT_THAT(Expand(dict, "{{#dict}}text"), Key(false));
+  // The content of unknown sections is dropped without being checked.
+  EXPECT_THAT(Expand(dict, "{{#outer}}{{#dict}}{{/outer}}"), Pair(true, ""));
+  dict.AddSectionDictionary("outer");
+  EXPECT_THAT(Expand(dict, "{{#outer}}{{#dict}}{{/outer}}"), Key(false));
+}
+
+TEST_F(TemplateDictionaryTest, StrayEndOfUnknownSection) {
+  const absl::string_view tmpl = "a{{/dict}}b";
+  TemplateDictionary dict("blabla");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "a{{/dict}}b"));
+}
+
+TEST_F(TemplateDictionaryTest, SectionAlsoUsedAsValue) {
+  const absl::string_view tmpl = "{{#dict}}{{/dict}}{{dict}}";
+  TemplateDictionary dict("blabla");
+  EXPECT_THAT(Expand(dict, tmpl), Key(false));
+}
+
+TEST_F(TemplateDictionaryTest, ParentLookup) {
+  // Parent values that sort before the section name take precedence over the
+  // section's own values, those that sort after it are only used if the
+  // section does not have them.
+  const absl::string_view tmpl = "{{#m}}{{a}} {{z}} {{y}}{{/m}}";
+  TemplateDictionary dict("blabla");
+  dict.SetValue("a", "parent_a");
+  dict.SetValue("z", "parent_z");
+  dict.SetValue("y", "parent_y");
+  TemplateDictionary* section = dict.AddSectionDictionary("m");
+  section->SetValue("a", "own_a");
+  section->SetValue("z", "own_z");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "parent_a own_z parent_y"));
+}
+
+TEST_F(TemplateDictionaryTest, GrandParentLookup) {
+  const absl::string_view tmpl = "{{#p}}{{#q}}{{a}} {{z}}{{/q}}{{/p}}";
+  TemplateDictionary dict("blabla");
+  dict.SetValue("a", "A");
+  dict.SetValue("z", "Z");
+  dict.AddSectionDictionary("p")->AddSectionDictionary("q");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "A Z"));
+}
+
+TEST_F(TemplateDictionaryTest, ParentSectionLookup) {
+  // Only sections that sort before the current section are found in parents.
+  const absl::string_view tmpl = "{{#m}}{{#a}}A{{/a}}{{#z}}Z{{/z}}{{/m}}";
+  TemplateDictionary dict("blabla");
+  dict.AddSectionDictionary("a");
+  dict.AddSectionDictionary("z");
+  dict.AddSectionDictionary("m");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "A"));
+}
+
+TEST_F(TemplateDictionaryTest, ValueWithTags) {
+  // Tags in values are expanded with the names that sort after the value name.
+  // Sections that sort before it count as unknown and get removed.
+  const absl::string_view tmpl = "{{b}}|{{y}}";
+  TemplateDictionary dict("blabla");
+  dict.SetValue("a", "A");
+  dict.SetValue("b", "<{{a}}{{c}}>");
+  dict.SetValue("c", "C");
+  dict.SetValue("y", "{{#s}}{{c}}{{/s}}");
+  dict.AddSectionDictionary("s");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "<{{a}}C>|"));
+}
+
+TEST_F(TemplateDictionaryTest, EmptyValueLineRemoval) {
+  TemplateDictionary dict("blabla");
+  dict.SetValue("empty", "");
+  dict.SetValue("full", "F");
+  // Alone on its line.
+  EXPECT_THAT(Expand(dict, "1\n  {{empty}}\n2"), Pair(true, "1\n2"));
+  // Not alone on its line.
+  EXPECT_THAT(Expand(dict, "1\n  x{{empty}}\n2"), Pair(true, "1\n  x\n2"));
+  EXPECT_THAT(Expand(dict, "1\n{{empty}}x\n2"), Pair(true, "1\nx\n2"));
+  // Another tag that is processed later keeps the line.
+  EXPECT_THAT(Expand(dict, "1\n{{empty}}{{full}}\n2"), Pair(true, "1\nF\n2"));
+  // Empty values that were removed first do not keep the line.
+  EXPECT_THAT(Expand(dict, "1\n{{empty}}{{empty}}\n2"), Pair(true, "1\n2"));
+  // At the start and the end of the template.
+  EXPECT_THAT(Expand(dict, "{{empty}}\n2"), Pair(true, "2"));
+  EXPECT_THAT(Expand(dict, "1\n{{empty}}"), Pair(true, "1\n"));
+}
+
+TEST_F(TemplateDictionaryTest, SectionLineRemoval) {
+  const absl::string_view tmpl = "1\n  {{#dict}}\n  {{foo}}\n  {{/dict}}\n2";
+  TemplateDictionary dict("blabla");
+  dict.AddSectionDictionary("dict")->SetValue("foo", "a");
+  dict.AddSectionDictionary("dict")->SetValue("foo", "b");
+  EXPECT_THAT(Expand(dict, tmpl), Pair(true, "1\n  a\n  b\n2"));
+  // Tags that are not alone on their line keep it.
+  EXPECT_THAT(Expand(dict, "1\n{{#dict}}x\n{{/dict}}2"),
+              Pair(true, "1\nx\nx\n2"));
+  EXPECT_THAT(Expand(dict, "1\n{{#dict}}\nx{{/dict}}\n2"),
+              Pair(true, "1\nxx\n2"));
+  // Tags of a removed line do not keep a later line.
+  dict.SetValue("blank", "");
+  EXPECT_THAT(Expand(dict,
+                     "{{#dict}} {{/dict}}{{#none}}\n{{/none}}{{#dict}}{{/dict}}"
+                     "\n{{blank}}\n2"),
+              Pair(true, "\n2"));
+}
+
+TEST_F(TemplateDictionaryTest, StringToTemplateCache) {
+  EXPECT_TRUE(StringToTemplateCache("cache_test", "{{foo}}", DO_NOT_STRIP));
+  EXPECT_TRUE(StringToTemplateCache("cache_test", "{{foo}}", DO_NOT_STRIP));
+  EXPECT_FALSE(StringToTemplateCache("cache_test", "{{bar}}", DO_NOT_STRIP));
+  TemplateDictionary dict("cache_test");
+  dict.SetValue("foo", "foo");
+  std::string output;
+  EXPECT_TRUE(ExpandTemplate("cache_test", DO_NOT_STRIP, &dict, &output));
+  EXPECT_THAT(output, "foo");
+}
+
 }  // namespace
 }  // namespace proto_builder::oss
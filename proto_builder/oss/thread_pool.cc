@@ -0,0 +1,111 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/thread_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+
+namespace proto_builder::oss {
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  num_threads = std::max<size_t>(num_threads, 1);
+  queues_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    queues_.push_back(std::make_unique<WorkQueue>());
+  }
+  workers_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  Wait();
+  {
+    absl::MutexLock lock(&mu_);
+    stop_ = true;
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Schedule(std::function<void()> task) {
+  absl::MutexLock lock(&mu_);
+  WorkQueue& queue = *queues_[next_queue_];
+  next_queue_ = (next_queue_ + 1) % queues_.size();
+  {
+    absl::MutexLock queue_lock(&queue.mu);
+    queue.tasks.push_back(std::move(task));
+  }
+  ++queued_;
+  ++pending_;
+}
+
+void ThreadPool::Wait() {
+  absl::MutexLock lock(&mu_);
+  mu_.Await(absl::Condition(this, &ThreadPool::AllDone));
+}
+
+std::function<void()> ThreadPool::TakeTask(size_t index) {
+  {
+    WorkQueue& own = *queues_[index];
+    absl::MutexLock lock(&own.mu);
+    if (!own.tasks.empty()) {
+      std::function<void()> task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return task;
+    }
+  }
+  for (size_t offset = 1; offset < queues_.size(); ++offset) {
+    WorkQueue& victim = *queues_[(index + offset) % queues_.size()];
+    absl::MutexLock lock(&victim.mu);
+    if (!victim.tasks.empty()) {
+      std::function<void()> task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  while (true) {
+    {
+      absl::MutexLock lock(&mu_);
+      mu_.Await(absl::Condition(this, &ThreadPool::HasWorkOrStopped));
+      if (queued_ == 0) {
+        return;  // Stopped and no more work.
+      }
+      // Reserve one task; it is guaranteed to be found below since tasks are
+      // enqueued before `queued_` is incremented and only ever removed after a
+      // reservation.
+      --queued_;
+    }
+    std::function<void()> task = TakeTask(index);
+    task();
+    absl::MutexLock lock(&mu_);
+    --pending_;
+  }
+}
+
+}  // namespace proto_builder::oss
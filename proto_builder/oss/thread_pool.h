@@ -0,0 +1,92 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_THREAD_POOL_H_
+#define PROTO_BUILDER_OSS_THREAD_POOL_H_
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace proto_builder::oss {
+
+// A simple fixed size work-stealing thread pool.
+//
+// Every worker owns a queue. Scheduled tasks are distributed round-robin over
+// the worker queues. A worker takes tasks from the front of its own queue and
+// when that is empty steals from the back of another worker's queue. That
+// keeps all workers busy when task cost varies widely (e.g. a few very large
+// messages among many small ones).
+//
+// The pool makes no ordering guarantees. Callers that need deterministic
+// results must write them into pre-allocated, per-task slots.
+class ThreadPool {
+ public:
+  // Starts `num_threads` workers (at least one).
+  explicit ThreadPool(size_t num_threads);
+
+  // Waits for all scheduled tasks to finish, then joins all workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Schedules `task` for execution on one of the workers.
+  void Schedule(std::function<void()> task) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until all scheduled tasks have finished.
+  void Wait() ABSL_LOCKS_EXCLUDED(mu_);
+
+  size_t num_threads() const { return workers_.size(); }
+
+ private:
+  struct WorkQueue {
+    absl::Mutex mu;
+    std::deque<std::function<void()>> tasks ABSL_GUARDED_BY(mu);
+  };
+
+  void WorkerLoop(size_t index) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Pops from the front of queue `index` or steals from the back of another.
+  std::function<void()> TakeTask(size_t index);
+
+  bool HasWorkOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queued_ > 0 || stop_;
+  }
+
+  bool AllDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pending_ == 0;
+  }
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::vector<std::thread> workers_;
+
+  absl::Mutex mu_;
+  size_t next_queue_ ABSL_GUARDED_BY(mu_) = 0;
+  size_t queued_ ABSL_GUARDED_BY(mu_) = 0;   // Tasks not yet taken.
+  size_t pending_ ABSL_GUARDED_BY(mu_) = 0;  // Tasks not yet finished.
+  bool stop_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_THREAD_POOL_H_
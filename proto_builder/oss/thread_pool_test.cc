@@ -0,0 +1,95 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+
+namespace proto_builder::oss {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+
+TEST(ThreadPoolTest, AtLeastOneThread) {
+  ThreadPool pool(0);
+  EXPECT_THAT(pool.num_threads(), Eq(1));
+  int value = 0;
+  pool.Schedule([&value] { value = 42; });
+  pool.Wait();
+  EXPECT_THAT(value, Eq(42));
+}
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  constexpr size_t kNumTasks = 1000;
+  std::vector<int> results(kNumTasks, 0);
+  {
+    ThreadPool pool(4);
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      pool.Schedule([&results, i] { results[i] = 1; });
+    }
+    pool.Wait();
+    EXPECT_THAT(results, Each(1));
+  }
+}
+
+TEST(ThreadPoolTest, WaitCanBeCalledRepeatedly) {
+  std::atomic<int> count{0};
+  ThreadPool pool(3);
+  for (int round = 1; round <= 3; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      pool.Schedule([&count] { ++count; });
+    }
+    pool.Wait();
+    EXPECT_THAT(count.load(), Eq(round * 10));
+  }
+}
+
+TEST(ThreadPoolTest, IdleWorkersStealFromBlockedWorker) {
+  // With two workers and round-robin distribution the blocking task and half
+  // of the others land on the same queue. The other worker must steal them.
+  absl::Notification release;
+  absl::BlockingCounter others(9);
+  ThreadPool pool(2);
+  pool.Schedule([&release] { release.WaitForNotification(); });
+  for (int i = 0; i < 9; ++i) {
+    pool.Schedule([&others] { others.DecrementCount(); });
+  }
+  others.Wait();
+  release.Notify();
+  pool.Wait();
+}
+
+TEST(ThreadPoolTest, DestructorFinishesPendingTasks) {
+  std::atomic<int> count{0};
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 100; ++i) {
+      pool.Schedule([&count] { ++count; });
+    }
+  }
+  EXPECT_THAT(count.load(), Eq(100));
+}
+
+}  // namespace
+}  // namespace proto_builder::oss
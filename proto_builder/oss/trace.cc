@@ -0,0 +1,160 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/trace.h"
+
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
+
+namespace proto_builder::oss {
+
+namespace {
+
+struct Event {
+  std::string name;
+  std::string args;
+  absl::Time start;
+  absl::Duration duration;
+  int tid;
+};
+
+struct TraceData {
+  absl::Time start;
+  std::vector<Event> events;
+  // Chrome shows small thread ids much nicer than hashed std::thread::ids.
+  std::map<std::thread::id, int> thread_ids;
+};
+
+ABSL_CONST_INIT absl::Mutex trace_mu(absl::kConstInit);
+
+TraceData& GetTraceData() ABSL_EXCLUSIVE_LOCKS_REQUIRED(trace_mu) {
+  static auto& trace_data = *new TraceData();
+  return trace_data;
+}
+
+std::string JsonString(absl::string_view str) {
+  std::string result = "\"";
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        result.append("\\\"");
+        break;
+      case '\\':
+        result.append("\\\\");
+        break;
+      case '\n':
+        result.append("\\n");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", static_cast<int>(c));
+        } else {
+          result.push_back(c);
+        }
+    }
+  }
+  result.push_back('"');
+  return result;
+}
+
+}  // namespace
+
+std::atomic<bool> Trace::active_{false};
+
+void Trace::Start() {
+  absl::MutexLock lock(&trace_mu);
+  TraceData& trace_data = GetTraceData();
+  trace_data.start = absl::Now();
+  trace_data.events.clear();
+  trace_data.thread_ids.clear();
+  active_ = true;
+}
+
+std::string Trace::Stop() {
+  absl::MutexLock lock(&trace_mu);
+  active_ = false;
+  const TraceData& trace_data = GetTraceData();
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  absl::string_view separator = "\n";
+  for (const Event& event : trace_data.events) {
+    absl::StrAppendFormat(
+        &json,
+        "%s{\"name\":%s,\"cat\":\"proto_builder\",\"ph\":\"X\",\"ts\":%.3f,"
+        "\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{%s}}",
+        separator, JsonString(event.name),
+        absl::ToDoubleMicroseconds(event.start - trace_data.start),
+        absl::ToDoubleMicroseconds(event.duration), getpid(), event.tid,
+        absl::StripSuffix(event.args, ","));
+    separator = ",\n";
+  }
+  json.append("\n]}\n");
+  return json;
+}
+
+TraceScope::TraceScope(absl::string_view name) : active_(Trace::IsActive()) {
+  if (active_) {
+    name_ = std::string(name);
+    start_ = absl::Now();
+  }
+}
+
+TraceScope::~TraceScope() {
+  if (!active_ || !Trace::IsActive()) {
+    return;
+  }
+  const absl::Duration duration = absl::Now() - start_;
+  absl::MutexLock lock(&trace_mu);
+  TraceData& trace_data = GetTraceData();
+  if (start_ < trace_data.start) {
+    return;  // Started before the active trace.
+  }
+  const int tid =
+      trace_data.thread_ids
+          .try_emplace(std::this_thread::get_id(), trace_data.thread_ids.size())
+          .first->second;
+  trace_data.events.push_back({
+      .name = std::move(name_),
+      .args = std::move(args_),
+      .start = start_,
+      .duration = duration,
+      .tid = tid,
+  });
+}
+
+void TraceScope::AddArg(absl::string_view key, absl::string_view value) {
+  if (active_) {
+    absl::StrAppend(&args_, JsonString(key), ":", JsonString(value), ",");
+  }
+}
+
+void TraceScope::AddArg(absl::string_view key, int64_t value) {
+  if (active_) {
+    absl::StrAppend(&args_, JsonString(key), ":", value, ",");
+  }
+}
+
+}  // namespace proto_builder::oss
@@ -0,0 +1,74 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_TRACE_H_
+#define PROTO_BUILDER_OSS_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace proto_builder::oss {
+
+// Process wide collector of trace events in the Chrome trace-event format
+// (load the output in chrome://tracing or https://ui.perfetto.dev).
+//
+// Events are recorded with `TraceScope`. While no trace is active, scopes do
+// nothing but check a flag.
+class Trace {
+ public:
+  // Starts a new trace, dropping all events of a previous trace.
+  static void Start();
+
+  // Stops the active trace and returns its events as trace-event JSON.
+  static std::string Stop();
+
+  static bool IsActive() { return active_.load(std::memory_order_relaxed); }
+
+ private:
+  static std::atomic<bool> active_;
+};
+
+// Records a complete event that spans the lifetime of the scope, if a trace is
+// active when the scope is created.
+//
+//   TraceScope trace("WriteMessage");
+//   trace.AddArg("message", descriptor.full_name());
+class TraceScope {
+ public:
+  explicit TraceScope(absl::string_view name);
+  ~TraceScope();
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  // Adds an argument that is shown with the event.
+  void AddArg(absl::string_view key, absl::string_view value);
+  void AddArg(absl::string_view key, int64_t value);
+
+ private:
+  const bool active_;
+  absl::Time start_;
+  std::string name_;
+  std::string args_;  // JSON members, each followed by ','.
+};
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_TRACE_H_
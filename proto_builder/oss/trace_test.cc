@@ -0,0 +1,78 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/trace.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+
+namespace proto_builder::oss {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::StartsWith;
+
+TEST(TraceTest, Inactive) {
+  ASSERT_FALSE(Trace::IsActive());
+  { TraceScope trace("Dropped"); }
+  Trace::Start();
+  EXPECT_TRUE(Trace::IsActive());
+  EXPECT_THAT(Trace::Stop(),
+              AllOf(StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["),
+                    Not(HasSubstr("Dropped"))));
+  EXPECT_FALSE(Trace::IsActive());
+}
+
+TEST(TraceTest, Events) {
+  Trace::Start();
+  {
+    TraceScope outer("Outer");
+    outer.AddArg("lines", 42);
+    {
+      TraceScope inner("Inner");
+      inner.AddArg("message", "foo.Bar");
+      inner.AddArg("escaped", "\"a\\b\"\n\x01");
+    }
+  }
+  const std::string json = Trace::Stop();
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"Outer\",\"cat\":\"proto_builder\","
+                              "\"ph\":\"X\",\"ts\":"));
+  EXPECT_THAT(json, HasSubstr("\"args\":{\"lines\":42}}"));
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"Inner\""));
+  EXPECT_THAT(json, HasSubstr("\"args\":{\"message\":\"foo.Bar\","
+                              "\"escaped\":\"\\\"a\\\\b\\\"\\n\\u0001\"}}"));
+  // A new trace drops the previous events.
+  Trace::Start();
+  EXPECT_THAT(Trace::Stop(), Not(HasSubstr("Outer")));
+}
+
+TEST(TraceTest, Threads) {
+  Trace::Start();
+  { TraceScope trace("Main"); }
+  std::thread thread([] { TraceScope trace("Thread"); });
+  thread.join();
+  const std::string json = Trace::Stop();
+  EXPECT_THAT(json, HasSubstr("\"tid\":0,\"args\":{}}"));
+  EXPECT_THAT(json, HasSubstr("\"tid\":1,\"args\":{}}"));
+}
+
+}  // namespace
+}  // namespace proto_builder::oss
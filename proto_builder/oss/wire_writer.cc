@@ -0,0 +1,193 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/wire_writer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "absl/strings/string_view.h"
+
+namespace proto_builder::oss {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+void AppendVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+WireWriter::WireWriter(WireWriter* parent, int field_number)
+    : output_(parent->output_) {
+  if (parent->lengths_ == nullptr) {
+    own_lengths_ = std::make_unique<LongLengths>();
+    lengths_ = own_lengths_.get();
+  } else {
+    lengths_ = parent->lengths_;
+    extra_at_start_ = lengths_->extra;
+  }
+  WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  length_pos_ = output_->size();
+  output_->push_back('\0');
+}
+
+WireWriter::~WireWriter() {
+  if (output_ == nullptr || length_pos_ == std::string::npos) {
+    return;
+  }
+  // The final length includes the varints that are still to be inserted.
+  const std::size_t length =
+      output_->size() - length_pos_ - 1 + lengths_->extra - extra_at_start_;
+  if (length < 0x80) {
+    (*output_)[length_pos_] = static_cast<char>(length);
+  } else {
+    lengths_->lengths.push_back({length_pos_, length});
+    lengths_->extra +=
+        ::google::protobuf::io::CodedOutputStream::VarintSize64(length) - 1;
+  }
+  if (own_lengths_ != nullptr && !own_lengths_->lengths.empty()) {
+    InsertLongLengths();
+  }
+}
+
+// Moves every byte at most once: from the end to the front, each part between
+// two long lengths is moved by the size of the varints before it.
+void WireWriter::InsertLongLengths() {
+  std::vector<LongLength>& lengths = own_lengths_->lengths;
+  std::sort(lengths.begin(), lengths.end(),
+            [](const LongLength& a, const LongLength& b) {
+              return a.pos < b.pos;
+            });
+  std::size_t end = output_->size();
+  output_->resize(end + own_lengths_->extra);
+  char* const data = output_->data();
+  std::size_t dest_end = output_->size();
+  for (auto it = lengths.rbegin(); it != lengths.rend(); ++it) {
+    const std::size_t content = it->pos + 1;
+    dest_end -= end - content;
+    std::memmove(data + dest_end, data + content, end - content);
+    std::string varint;
+    AppendVarint(it->length, &varint);
+    dest_end -= varint.size();
+    std::memcpy(data + dest_end, varint.data(), varint.size());
+    end = it->pos;
+  }
+}
+
+void WireWriter::WriteInt32(int field_number, int32_t value) {
+  // Negative int32 values are sign extended to ten bytes on the wire.
+  WriteInt64(field_number, value);
+}
+
+void WireWriter::WriteInt64(int field_number, int64_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+  WriteVarint(static_cast<uint64_t>(value));
+}
+
+void WireWriter::WriteUInt32(int field_number, uint32_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+  WriteVarint(value);
+}
+
+void WireWriter::WriteUInt64(int field_number, uint64_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+  WriteVarint(value);
+}
+
+void WireWriter::WriteSInt32(int field_number, int32_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+  WriteVarint(WireFormatLite::ZigZagEncode32(value));
+}
+
+void WireWriter::WriteSInt64(int field_number, int64_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_VARINT);
+  WriteVarint(WireFormatLite::ZigZagEncode64(value));
+}
+
+void WireWriter::WriteFixed32(int field_number, uint32_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_FIXED32);
+  WriteLittleEndian(value, 4);
+}
+
+void WireWriter::WriteFixed64(int field_number, uint64_t value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_FIXED64);
+  WriteLittleEndian(value, 8);
+}
+
+void WireWriter::WriteSFixed32(int field_number, int32_t value) {
+  WriteFixed32(field_number, static_cast<uint32_t>(value));
+}
+
+void WireWriter::WriteSFixed64(int field_number, int64_t value) {
+  WriteFixed64(field_number, static_cast<uint64_t>(value));
+}
+
+void WireWriter::WriteFloat(int field_number, float value) {
+  WriteFixed32(field_number, WireFormatLite::EncodeFloat(value));
+}
+
+void WireWriter::WriteDouble(int field_number, double value) {
+  WriteFixed64(field_number, WireFormatLite::EncodeDouble(value));
+}
+
+void WireWriter::WriteBool(int field_number, bool value) {
+  WriteUInt32(field_number, value ? 1 : 0);
+}
+
+void WireWriter::WriteEnum(int field_number, int value) {
+  WriteInt32(field_number, value);
+}
+
+void WireWriter::WriteString(int field_number, absl::string_view value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  WriteVarint(value.size());
+  output_->append(value.data(), value.size());
+}
+
+void WireWriter::WriteMessage(int field_number,
+                              const ::google::protobuf::MessageLite& value) {
+  WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  WriteVarint(value.ByteSizeLong());
+  value.AppendToString(output_);
+}
+
+void WireWriter::WriteTag(int field_number, int wire_type) {
+  WriteVarint((static_cast<uint32_t>(field_number) << 3) |
+              static_cast<uint32_t>(wire_type));
+}
+
+void WireWriter::WriteVarint(uint64_t value) { AppendVarint(value, output_); }
+
+void WireWriter::WriteLittleEndian(uint64_t value, int size) {
+  for (int i = 0; i < size; ++i) {
+    output_->push_back(static_cast<char>(value & 0xFF));
+    value >>= 8;
+  }
+}
+
+}  // namespace proto_builder::oss
@@ -0,0 +1,117 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#ifndef PROTO_BUILDER_OSS_WIRE_WRITER_H_
+#define PROTO_BUILDER_OSS_WIRE_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/message_lite.h"
+#include "absl/strings/string_view.h"
+
+namespace proto_builder::oss {
+
+// Appends the wire format of a message to a string without ever creating the
+// message itself. Fields are written in the order the setters are called, so
+// callers that want canonical output write them in field number order.
+//
+// A nested writer, created with a parent writer and a field number, writes a
+// length delimited sub message into the parent's output. The length is
+// reserved as a single byte and filled in once the nested writer is destroyed,
+// so a nested writer must be destroyed before its parent writes again. Lengths
+// of 128 and more need a longer varint. Rather than shifting the content for
+// each of them (which would copy deeply nested content once per level), they
+// are collected and the outermost nested writer inserts all of them in a
+// single pass when it is destroyed. Only then is the output complete.
+//
+// Repeated scalar fields are written unpacked, which every parser accepts.
+class WireWriter {
+ public:
+  explicit WireWriter(std::string* output) : output_(output) {}
+  WireWriter(WireWriter* parent, int field_number);
+
+  WireWriter(WireWriter&& other) noexcept
+      : output_(other.output_),
+        length_pos_(other.length_pos_),
+        own_lengths_(std::move(other.own_lengths_)),
+        lengths_(other.lengths_),
+        extra_at_start_(other.extra_at_start_) {
+    other.output_ = nullptr;
+  }
+  WireWriter(const WireWriter&) = delete;
+  WireWriter& operator=(const WireWriter&) = delete;
+  WireWriter& operator=(WireWriter&&) = delete;
+
+  ~WireWriter();
+
+  void WriteInt32(int field_number, int32_t value);
+  void WriteInt64(int field_number, int64_t value);
+  void WriteUInt32(int field_number, uint32_t value);
+  void WriteUInt64(int field_number, uint64_t value);
+  void WriteSInt32(int field_number, int32_t value);
+  void WriteSInt64(int field_number, int64_t value);
+  void WriteFixed32(int field_number, uint32_t value);
+  void WriteFixed64(int field_number, uint64_t value);
+  void WriteSFixed32(int field_number, int32_t value);
+  void WriteSFixed64(int field_number, int64_t value);
+  void WriteFloat(int field_number, float value);
+  void WriteDouble(int field_number, double value);
+  void WriteBool(int field_number, bool value);
+  void WriteEnum(int field_number, int value);
+  void WriteString(int field_number, absl::string_view value);
+  void WriteMessage(int field_number,
+                    const ::google::protobuf::MessageLite& value);
+
+  // The output this writer (or its outermost parent) appends to.
+  std::string* output() const { return output_; }
+
+ private:
+  void WriteTag(int field_number, int wire_type);
+  void WriteVarint(uint64_t value);
+  void WriteLittleEndian(uint64_t value, int size);
+  void InsertLongLengths();
+
+  // A length that does not fit into its reserved byte.
+  struct LongLength {
+    std::size_t pos;  // Position of the reserved byte.
+    std::size_t length;
+  };
+
+  // The long lengths within an outermost nested writer.
+  struct LongLengths {
+    std::vector<LongLength> lengths;
+    // Bytes the varints need on top of their reserved bytes.
+    std::size_t extra = 0;
+  };
+
+  std::string* output_;
+  // Position of the reserved length byte for nested writers.
+  std::size_t length_pos_ = std::string::npos;
+  // Owned by the outermost nested writer, shared with the ones inside of it.
+  std::unique_ptr<LongLengths> own_lengths_;
+  LongLengths* lengths_ = nullptr;
+  // `lengths_->extra` when this writer started, so the difference to it at
+  // the end is the extra size of its content.
+  std::size_t extra_at_start_ = 0;
+};
+
+}  // namespace proto_builder::oss
+
+#endif  // PROTO_BUILDER_OSS_WIRE_WRITER_H_
@@ -0,0 +1,133 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/oss/wire_writer.h"
+
+#include <string>
+
+#include "proto_builder/oss/tests/simple_message.pb.h"
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+
+namespace proto_builder::oss {
+namespace {
+
+using ::testing::oss::EqualsProto;
+
+TEST(WireWriterTest, Scalars) {
+  std::string output;
+  WireWriter writer(&output);
+  writer.WriteInt32(1, -3);
+  writer.WriteInt32(2, 1);
+  writer.WriteInt32(2, 300);
+  SimpleMessage message;
+  message.set_one(-3);
+  message.add_two(1);
+  message.add_two(300);
+  EXPECT_EQ(output, message.SerializeAsString());
+  ASSERT_TRUE(message.ParseFromString(output));
+  EXPECT_THAT(message, EqualsProto("one: -3 two: 1 two: 300"));
+}
+
+TEST(WireWriterTest, NestedWriterMatchesWriteMessage) {
+  SimpleMessage sub;
+  sub.set_one(2);
+  std::string expected;
+  WireWriter(&expected).WriteMessage(3, sub);
+  std::string output;
+  {
+    WireWriter writer(&output);
+    WireWriter nested(&writer, 3);
+    nested.WriteInt32(1, 2);
+  }
+  EXPECT_EQ(output, expected);
+}
+
+TEST(WireWriterTest, NestedWriterPatchesLongLength) {
+  SimpleMessage sub;
+  std::string output;
+  WireWriter writer(&output);
+  {
+    WireWriter nested(&writer, 3);
+    for (int i = 0; i < 200; ++i) {
+      nested.WriteInt32(2, i);
+      sub.add_two(i);
+    }
+  }
+  writer.WriteInt32(1, 7);
+  std::string expected;
+  WireWriter expected_writer(&expected);
+  expected_writer.WriteMessage(3, sub);
+  expected_writer.WriteInt32(1, 7);
+  EXPECT_EQ(output, expected);
+}
+
+// Writes `count` values, then `depth` levels of nested writers below field 3,
+// then `count` values again. Returns the same as a length delimited string.
+std::string WriteNested(WireWriter* writer, int depth, int count) {
+  std::string content;
+  WireWriter expected(&content);
+  for (int i = 0; i < count; ++i) {
+    writer->WriteInt32(2, i);
+    expected.WriteInt32(2, i);
+  }
+  if (depth > 0) {
+    WireWriter nested(writer, 3);
+    expected.WriteString(3, WriteNested(&nested, depth - 1, count));
+  }
+  for (int i = 0; i < count; ++i) {
+    writer->WriteInt32(1, i);
+    expected.WriteInt32(1, i);
+  }
+  return content;
+}
+
+TEST(WireWriterTest, DeeplyNestedLongLengths) {
+  // Inner levels are short, outer ones need two and three byte lengths.
+  for (const int count : {0, 10, 100, 5000}) {
+    std::string output;
+    std::string expected;
+    {
+      WireWriter writer(&output);
+      expected = WriteNested(&writer, 5, count);
+    }
+    EXPECT_EQ(output, expected) << count;
+  }
+}
+
+TEST(WireWriterTest, SiblingsWithLongLengths) {
+  std::string output;
+  std::string expected;
+  {
+    WireWriter writer(&output);
+    WireWriter expected_writer(&expected);
+    WireWriter outer(&writer, 3);
+    std::string outer_content;
+    WireWriter outer_expected(&outer_content);
+    // A short sibling between two long ones, each with a long child.
+    for (const int count : {100, 1, 100}) {
+      WireWriter nested(&outer, 3);
+      outer_expected.WriteString(3, WriteNested(&nested, 1, count));
+    }
+    outer.WriteInt32(1, 1);
+    outer_expected.WriteInt32(1, 1);
+    expected_writer.WriteString(3, outer_content);
+  }
+  EXPECT_EQ(output, expected);
+}
+
+}  // namespace
+}  // namespace proto_builder::oss
@@ -398,6 +398,10 @@ def _proto_builder_impl(ctx):
     ]
     proto_files += direct_proto_files
 
+    # The tool reads the proto files from their serialized descriptor sets, so
+    # it does not need to parse (and Bazel does not need to stage) the sources.
+    descriptor_sets = proto_library_dep[ProtoInfo].transitive_descriptor_sets
+
     # Is there a validator dependency for the proto we are interested?
     use_validator = False
     validator_header = ""
@@ -474,61 +478,79 @@ def _proto_builder_impl(ctx):
     template_src_file = ctx.file._default_source_tpl if not (template_src) else template_src
     template_ifc_file = ctx.file._default_interface_header_tpl if not (template_ifc) else template_ifc
 
-    # Run proto_builder tool.
+    # Run proto_builder tool. The tool writes into intermediate files that get
+    # processed and formatted below. This allows to run the tool as a
+    # persistent worker, which keeps configuration, templates and parsed proto
+    # files between actions.
+    raw_header_file = ctx.actions.declare_file(hdr_out_name + ".raw")
+    raw_source_file = ctx.actions.declare_file(src_out_name + ".raw")
+    raw_builder_files = [raw_source_file, raw_header_file]
+    if make_interface:
+        raw_interface_file = ctx.actions.declare_file(ifc_out_name + ".raw")
+        raw_interface_filename = raw_interface_file.path
+        raw_builder_files.append(raw_interface_file)
+    else:
+        raw_interface_filename = ""
+    args = ctx.actions.args()
+    args.add("--proto={}:{}".format(protos, direct_proto_paths))
+    args.add("--header=" + raw_header_file.path)
+    args.add("--source=" + raw_source_file.path)
+    args.add("--interface=" + raw_interface_filename)
+    args.add("--header_in=" + (template_hdr and template_hdr.path or "default"))
+    args.add("--source_in=" + (template_src and template_src.path or "default"))
+    args.add("--interface_in=" + (template_ifc and template_ifc.path or "default"))
+    args.add("--tpl_value_header=" + (ctx.attr.tpl_value_header or header_file.path))
+    args.add("--tpl_value_interface=" + interface_filename)
+    args.add("--protofiles=" + protofiles_flag)
+    args.add("--proto_paths=" + proto_paths)
+    args.add_joined(
+        descriptor_sets,
+        join_with = ",",
+        format_joined = "--descriptor_set_in=%s",
+    )
+    args.add("--make_interface={}".format(ctx.attr.make_interface))
+    args.add("--inline_trivial_setters={}".format(ctx.attr.inline_trivial_setters))
+    args.add("--max_field_depth={}".format(ctx.attr.max_field_depth))
+    args.add("--use_validator={}".format(use_validator))
+    args.add("--validator_header=" + validator_header)
+    args.add("--use_global_db=0")
+    args.add("--proto_builder_config=" + proto_builder_config_file)
+    args.add("--conv_deps_file=" + conv_deps_file.path)
+    args.add("--template_builder_strip_prefix_dir=" + ctx.genfiles_dir.path)
+    args.use_param_file("--flagfile=%s", use_always = True)
+    args.set_param_file_format("multiline")
+    ctx.actions.run(
+        outputs = raw_builder_files,
+        inputs = depset(
+            template_files + [conv_deps_file] + proto_builder_config_files,
+            transitive = [descriptor_sets],
+        ),
+        executable = ctx.executable._proto_builder_tool,
+        arguments = [args],
+        execution_requirements = {
+            "requires-worker-protocol": "proto",
+            "supports-workers": "1",
+        },
+        mnemonic = "CPPProtoBuilder",
+        progress_message = "CPP Proto Builder on files: %s" % (direct_proto_paths),
+    )
+
+    # Process and format the generated files.
     ctx.actions.run_shell(
         outputs = builder_files,
         tools = [
-            ctx.executable._proto_builder_tool,
+            ctx.executable._stable_clang_format_tool,
         ],
-        inputs = proto_files + template_files + [
-            ctx.executable._proto_builder_tool,
+        inputs = raw_builder_files + template_files + [
             ctx.executable._stable_clang_format_tool,
-            conv_deps_file,
-        ] + proto_builder_config_files,
+        ],
         command = "\n".join([
-            # Instantiate proto builder tool (Compute stage)
-            """{} \
-            --proto="{protos}:{direct_proto_paths}" \
-            --header="{header_file}" \
-            --source="{source_file}" \
-            --interface="{interface_file}" \
-            --header_in="{header_tpl}" \
-            --source_in="{source_tpl}" \
-            --interface_in="{interface_tpl}" \
-            --tpl_value_header="{tpl_value_header}" \
-            --protofiles="{protofiles}" \
-            --proto_paths="{proto_paths}" \
-            --make_interface="{make_interface}" \
-            --max_field_depth="{max_field_depth}" \
-            --use_validator="{use_validator}" \
-            --validator_header="{validator_header}" \
-            --use_global_db=0 \
-            --proto_builder_config="{proto_builder_config}" \
-            --conv_deps_file="{conv_deps_file}" \
-            --template_builder_strip_prefix_dir="{strip_prefix_dir}";""".format(
-                ctx.executable._proto_builder_tool.path,
-                protos = protos,
-                direct_proto_paths = direct_proto_paths,
-                header_file = header_file.path,
-                source_file = source_file.path,
-                interface_file = interface_filename,
-                header_tpl = template_hdr and template_hdr.path or "default",
-                source_tpl = template_src and template_src.path or "default",
-                interface_tpl = template_ifc and template_ifc.path or "default",
-                tpl_value_header = ctx.attr.tpl_value_header or "",
-                protofiles = protofiles_flag,
-                proto_paths = proto_paths,
-                make_interface = ctx.attr.make_interface,
-                max_field_depth = ctx.attr.max_field_depth,
-                use_validator = use_validator,
-                validator_header = validator_header,
-                proto_builder_config = proto_builder_config_file,
-                conv_deps_file = conv_deps_file.path,
-                strip_prefix_dir = ctx.genfiles_dir.path,
-            ),
-            "if [ $? -ne 0 ]; then",
-            "exit -1",
-            "fi",
+            "cat {} > {}".format(raw_header_file.path, header_file.path),
+            "cat {} > {}".format(raw_source_file.path, source_file.path),
+            "cat {} > {}".format(
+                raw_interface_filename,
+                interface_filename,
+            ) if ctx.attr.make_interface else "",
             # Post processing stage
             proto_builder_config.proto_builder_processing(
                 template_hdr_file,
@@ -560,8 +582,8 @@ def _proto_builder_impl(ctx):
             ) if ctx.attr.make_interface else "",
             "exit 0",
         ]),
-        mnemonic = "CPPProtoBuilder",
-        progress_message = "CPP Proto Builder on files: %s" % (direct_proto_paths),
+        mnemonic = "CPPProtoBuilderFormat",
+        progress_message = "CPP Proto Builder formatting: %s" % (direct_proto_paths),
     )
 
     # If configured, compile and link generated sources.
@@ -729,6 +751,12 @@ _proto_builder_attr = {
         doc = "Whether to generate an interface.",
         default = False,
     ),
+    "inline_trivial_setters": attr.bool(
+        doc = "Whether setters that only store the value are defined in the " +
+              "header. Messages can override this with their " +
+              "inline_trivial_setters option.",
+        default = False,
+    ),
     "source_file": attr.output(
         doc = "The generated source file.",
     ),
@@ -844,6 +872,7 @@ def cc_proto_builder_library(
         hdrs = None,
         ifcs = None,
         make_interface = False,
+        inline_trivial_setters = False,
         tpl_value_header = None,
         deps = [],
         testonly = None,
@@ -867,6 +896,7 @@ def cc_proto_builder_library(
       hdrs: Optional, see 'proto_builder' rule.
       ifcs: Optional, see 'proto_builder' rule.
       make_interface: Optional, see 'proto_builder' rule.
+      inline_trivial_setters: Optional, see 'proto_builder' rule.
       tpl_value_header: See 'proto_builder' rule.
       deps: Dependencies for the cc_library rule. The list must include all
             dependencies for the code in srcs/hdrs.
@@ -916,6 +946,7 @@ def cc_proto_builder_library(
         header_file = filename + ".h",
         interface_file = interface_filename if make_interface else None,
         make_interface = make_interface,
+        inline_trivial_setters = inline_trivial_setters,
         testonly = testonly,
         visibility = visibility,
         cc_compile_and_link = not proto_builder_config.USE_CC_LIBRARY_MACRO,
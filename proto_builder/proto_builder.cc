@@ -14,8 +14,14 @@
 
 // READ: https://google.github.io/cpp-proto-builder
 
+#include <unistd.h>
+
 #include <limits>
+#include <memory>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "proto_builder/oss/init_program.h"
 #include "proto_builder/descriptor_util.h"
@@ -23,14 +29,21 @@
 #include "proto_builder/message_builder.h"
 #include "proto_builder/oss/file.h"
 #include "proto_builder/oss/logging_macros.h"
+#include "proto_builder/oss/persistent_worker.h"
 #include "proto_builder/oss/sourcefile_database.h"
+#include "proto_builder/oss/trace.h"
 #include "proto_builder/oss/util.h"
+#include "proto_builder/proto_builder_batch.pb.h"
 #include "proto_builder/proto_builder_config.h"
 #include "proto_builder/proto_builder_data.h"
 #include "proto_builder/template_builder.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/text_format.h"
 #include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 
 ABSL_FLAG(
     std::string, proto, "",
@@ -74,6 +87,11 @@ ABSL_FLAG(std::string, tpl_value_header, "",
           "cyclic dependencies in proto_builder_test rules where it is not "
           "possible to generate the header with the intended file name.");
 
+ABSL_FLAG(std::string, tpl_value_interface, "",
+          "Same as --tpl_value_header but for the interface header (see "
+          "--interface). This allows to generate the files under a different "
+          "name than they are finally used with.");
+
 ABSL_FLAG(std::string, workdir, "", "Pass in ${PWD} to support bazel run.");
 
 ABSL_FLAG(size_t, max_field_depth, 0u,
@@ -92,21 +110,47 @@ ABSL_FLAG(std::string, validator_header, "",
 ABSL_FLAG(bool, make_interface, false,
           "Whether to make an additional interface header file.");
 
+ABSL_FLAG(bool, inline_trivial_setters, false,
+          "Whether setters that only store the value (no conversion, "
+          "predicate, source location or source include) are defined in the "
+          "header, so that they can be inlined across translation units. "
+          "Messages can override this with the inline_trivial_setters "
+          "option.");
+
+ABSL_FLAG(size_t, jobs, 1,
+          "Number of threads used to generate message builders (the output "
+          "is identical for any value).");
+
+ABSL_FLAG(bool, persistent_worker, false,
+          "Run as a Bazel persistent worker. Work requests are read from stdin "
+          "and answered on stdout. The configuration, templates and parsed "
+          "proto files are kept between requests.");
+
+ABSL_FLAG(bool, write_if_changed, false,
+          "Only write output files whose content changed. Unchanged files "
+          "keep their modification time, changed files are replaced "
+          "atomically.");
+
+ABSL_FLAG(std::string, trace_out, "",
+          "If set, write a Chrome trace-event JSON file with the time spent in "
+          "each phase (load, config, per message generation, expansion and "
+          "file writing). Open it in chrome://tracing or ui.perfetto.dev.");
+
+ABSL_FLAG(std::string, batch, "",
+          "ProtoBuilderBatch textproto file (see proto_builder_batch.proto). "
+          "Generates all of its targets in one process from one shared set of "
+          "loaded proto files. The other flags provide the defaults for the "
+          "targets.");
+
 namespace proto_builder {
 
-absl::Status WriteProtoBuilderFiles() {
-  if (!absl::GetFlag(FLAGS_conv_deps_file).empty()) {
-    QCHECK_OK(CheckConversionDependencies(absl::GetFlag(FLAGS_conv_deps_file)))
-        << absl::GetFlag(FLAGS_conv_deps_file);
-  }
-  auto [status, descriptor_util] = UnpackStatusOrDefault(  //
-      DescriptorUtil::Load(absl::GetFlag(FLAGS_proto),
-                           oss::SourceFileDatabase::GetProtoFilesFlag(),
-                           oss::SourceFileDatabase::GetProtoPathsFlag()),
-      DescriptorUtil::DefaultWillNotWork::kDefaultWillNotWork);
-  if (!status.ok()) {
-    return status;
-  }
+// Writes the files for the current flags, generated for the messages selected
+// in `descriptor_util`.
+absl::Status WriteProtoBuilderFiles(
+    const DescriptorUtil& descriptor_util,
+    const ProtoBuilderConfigManager& global_config) {
+  oss::TraceScope trace("WriteProtoBuilderFiles");
+  trace.AddArg("proto", absl::GetFlag(FLAGS_proto));
   const size_t max_field_depth =
       absl::GetFlag(FLAGS_max_field_depth)
           ? absl::GetFlag(FLAGS_max_field_depth)
@@ -120,11 +164,12 @@ absl::Status WriteProtoBuilderFiles() {
                          : absl::GetFlag(FLAGS_tpl_value_header),
                      absl::GetFlag(FLAGS_template_builder_strip_prefix_dir));
   const std::string interface =
-      StripPrefixDir(absl::GetFlag(FLAGS_interface),
+      StripPrefixDir(absl::GetFlag(FLAGS_tpl_value_interface).empty()
+                         ? absl::GetFlag(FLAGS_interface)
+                         : absl::GetFlag(FLAGS_tpl_value_interface),
                      absl::GetFlag(FLAGS_template_builder_strip_prefix_dir));
 
-  const ProtoBuilderConfigManager global_config;
-  BufferWriter writer;
+  ChunkedBufferWriter writer;
   const std::string header_template =
       absl::GetFlag(FLAGS_header_in) == "default"
           ? DefaultHeaderTemplate()
@@ -151,22 +196,33 @@ absl::Status WriteProtoBuilderFiles() {
                                         !validator_header.empty(),
                        .validator_header = validator_header,
                        .make_interface = absl::GetFlag(FLAGS_make_interface),
+                       .inline_trivial_setters =
+                           absl::GetFlag(FLAGS_inline_trivial_setters),
                        .tpl_iface = interface_template,
                        .interface_header = interface,
+                       .jobs = absl::GetFlag(FLAGS_jobs),
+                       .graph = descriptor_util.graph(),
                    })
                    .WriteBuilder();
       !s.ok()) {
     return s;
   }
 
-  if (auto s = writer.WriteFile(HEADER, absl::GetFlag(FLAGS_header)); !s.ok()) {
+  const file::oss::Options file_options{
+      .write_if_changed = absl::GetFlag(FLAGS_write_if_changed)};
+  if (auto s = writer.WriteFile(HEADER, absl::GetFlag(FLAGS_header),
+                                file_options);
+      !s.ok()) {
     return s;
   }
-  if (auto s = writer.WriteFile(SOURCE, absl::GetFlag(FLAGS_source)); !s.ok()) {
+  if (auto s = writer.WriteFile(SOURCE, absl::GetFlag(FLAGS_source),
+                                file_options);
+      !s.ok()) {
     return s;
   }
   if (absl::GetFlag(FLAGS_make_interface)) {
-    if (auto s = writer.WriteFile(INTERFACE, absl::GetFlag(FLAGS_interface));
+    if (auto s = writer.WriteFile(INTERFACE, absl::GetFlag(FLAGS_interface),
+                                  file_options);
         !s.ok()) {
       return s;
     }
@@ -174,6 +230,211 @@ absl::Status WriteProtoBuilderFiles() {
   return absl::OkStatus();
 }
 
+// Checks the --conv_deps_file if one is given. Errors are returned rather than
+// fatal, so that a persistent worker only fails the current request.
+absl::Status CheckConversionDependenciesFlag() {
+  const std::string conv_deps_file = absl::GetFlag(FLAGS_conv_deps_file);
+  if (conv_deps_file.empty()) {
+    return absl::OkStatus();
+  }
+  const absl::Status status = CheckConversionDependencies(conv_deps_file);
+  if (!status.ok()) {
+    return absl::Status(status.code(),
+                        absl::StrCat("--conv_deps_file '", conv_deps_file,
+                                     "': ", status.message()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteProtoBuilderFiles() {
+  if (absl::Status conv_status = CheckConversionDependenciesFlag();
+      !conv_status.ok()) {
+    return conv_status;
+  }
+  auto [status, descriptor_util] = UnpackStatusOrDefault(  //
+      DescriptorUtil::Load(absl::GetFlag(FLAGS_proto),
+                           oss::SourceFileDatabase::GetProtoFilesFlag(),
+                           oss::SourceFileDatabase::GetProtoPathsFlag(),
+                           oss::SourceFileDatabase::GetDescriptorSetInFlag()),
+      DescriptorUtil::DefaultWillNotWork::kDefaultWillNotWork);
+  if (!status.ok()) {
+    return status;
+  }
+  const ProtoBuilderConfigManager global_config;
+  return WriteProtoBuilderFiles(descriptor_util, global_config);
+}
+
+absl::Status CheckTargetFlags() {
+  for (const auto& [name, value] :
+       {std::make_pair("proto", absl::GetFlag(FLAGS_proto)),
+        std::make_pair("header", absl::GetFlag(FLAGS_header)),
+        std::make_pair("source", absl::GetFlag(FLAGS_source))}) {
+    if (value.empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Flag --", name, " must be set."));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Overrides the flags with the fields that are set in `target`.
+void SetFlagsFromTarget(const ProtoBuilderBatch::Target& target) {
+  if (target.has_proto()) {
+    absl::SetFlag(&FLAGS_proto, target.proto());
+  }
+  if (target.has_header()) {
+    absl::SetFlag(&FLAGS_header, target.header());
+  }
+  if (target.has_source()) {
+    absl::SetFlag(&FLAGS_source, target.source());
+  }
+  if (target.has_interface()) {
+    absl::SetFlag(&FLAGS_interface, target.interface());
+  }
+  if (target.has_tpl_value_header()) {
+    absl::SetFlag(&FLAGS_tpl_value_header, target.tpl_value_header());
+  }
+  if (target.has_tpl_value_interface()) {
+    absl::SetFlag(&FLAGS_tpl_value_interface, target.tpl_value_interface());
+  }
+  if (target.has_header_in()) {
+    absl::SetFlag(&FLAGS_header_in, target.header_in());
+  }
+  if (target.has_source_in()) {
+    absl::SetFlag(&FLAGS_source_in, target.source_in());
+  }
+  if (target.has_interface_in()) {
+    absl::SetFlag(&FLAGS_interface_in, target.interface_in());
+  }
+  if (target.has_max_field_depth()) {
+    absl::SetFlag(&FLAGS_max_field_depth, target.max_field_depth());
+  }
+  if (target.has_use_validator()) {
+    absl::SetFlag(&FLAGS_use_validator, target.use_validator());
+  }
+  if (target.has_validator_header()) {
+    absl::SetFlag(&FLAGS_validator_header, target.validator_header());
+  }
+  if (target.has_make_interface()) {
+    absl::SetFlag(&FLAGS_make_interface, target.make_interface());
+  }
+  if (target.has_inline_trivial_setters()) {
+    absl::SetFlag(&FLAGS_inline_trivial_setters,
+                  target.inline_trivial_setters());
+  }
+}
+
+// Writes the files of all targets in the --batch manifest `batch_file`. The
+// proto files of all targets are loaded once into a shared database and all
+// targets share the configuration.
+absl::Status WriteProtoBuilderBatch(const std::string& batch_file) {
+  oss::TraceScope trace("WriteProtoBuilderBatch");
+  auto [status, textproto] =
+      UnpackStatusOrDefault(file::oss::GetContents(batch_file));
+  if (!status.ok()) {
+    return status;
+  }
+  ProtoBuilderBatch batch;
+  if (!google::protobuf::TextFormat::ParseFromString(textproto, &batch)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot parse --batch file: '", batch_file, "'"));
+  }
+  trace.AddArg("targets", batch.target_size());
+  if (absl::Status conv_status = CheckConversionDependenciesFlag();
+      !conv_status.ok()) {
+    return conv_status;
+  }
+  std::vector<std::string> proto_files =
+      oss::SourceFileDatabase::GetProtoFilesFlag();
+  std::set<std::string> seen_files(proto_files.begin(), proto_files.end());
+  for (const auto& target : batch.target()) {
+    const std::string proto =
+        target.has_proto() ? target.proto() : absl::GetFlag(FLAGS_proto);
+    for (auto& proto_file : DescriptorUtil::GetProtoFlagFiles(proto)) {
+      if (seen_files.insert(proto_file).second) {
+        proto_files.push_back(std::move(proto_file));
+      }
+    }
+  }
+  auto [db_status, proto_db] = UnpackStatusOrDefault(
+      DescriptorUtil::LoadDatabase(
+          proto_files, oss::SourceFileDatabase::GetProtoPathsFlag(),
+          oss::SourceFileDatabase::GetDescriptorSetInFlag()));
+  if (!db_status.ok()) {
+    return db_status;
+  }
+  const ProtoBuilderConfigManager global_config;
+  for (int i = 0; i < batch.target_size(); ++i) {
+    absl::FlagSaver flag_saver;
+    SetFlagsFromTarget(batch.target(i));
+    absl::Status target_status = CheckTargetFlags();
+    if (target_status.ok()) {
+      auto [select_status, descriptor_util] = UnpackStatusOrDefault(
+          DescriptorUtil::Select(absl::GetFlag(FLAGS_proto), proto_db),
+          DescriptorUtil::DefaultWillNotWork::kDefaultWillNotWork);
+      target_status = select_status.ok()
+                          ? WriteProtoBuilderFiles(descriptor_util,
+                                                   global_config)
+                          : select_status;
+    }
+    if (!target_status.ok()) {
+      return absl::Status(
+          target_status.code(),
+          absl::StrCat("Batch target ", i, " (", absl::GetFlag(FLAGS_header),
+                       "): ", target_status.message()));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Runs `WriteProtoBuilderFiles` or `WriteProtoBuilderBatch` and writes the
+// --trace_out file if requested. The trace is written even if the run fails,
+// in which case the run's error is returned.
+absl::Status RunProtoBuilder() {
+  auto write = [] {
+    return absl::GetFlag(FLAGS_batch).empty()
+               ? WriteProtoBuilderFiles()
+               : WriteProtoBuilderBatch(absl::GetFlag(FLAGS_batch));
+  };
+  const std::string trace_out = absl::GetFlag(FLAGS_trace_out);
+  if (trace_out.empty()) {
+    return write();
+  }
+  oss::Trace::Start();
+  absl::Status status = write();
+  const std::string trace = oss::Trace::Stop();
+  // Keeps the first error.
+  status.Update(file::oss::SetContents(trace_out, trace));
+  return status;
+}
+
+absl::Status CheckRequiredFlags() {
+  if (!absl::GetFlag(FLAGS_batch).empty()) {
+    return absl::OkStatus();  // Checked for each target.
+  }
+  return CheckTargetFlags();
+}
+
+
+// Handles a single request in --persistent_worker mode. Every request starts
+// with the flags the worker was started with.
+int HandleWorkRequest(const std::vector<std::string>& arguments,
+                      std::string* output) {
+  absl::FlagSaver flag_saver;
+  absl::Status status = oss::SetFlagsFromArguments(arguments);
+  if (status.ok()) {
+    status = CheckRequiredFlags();
+  }
+  if (status.ok()) {
+    status = RunProtoBuilder();
+  }
+  if (!status.ok()) {
+    absl::StrAppend(output, status.ToString(), "\n");
+    return 1;
+  }
+  return 0;
+}
+
 }  // namespace proto_builder
 
 namespace {
@@ -194,13 +455,21 @@ declaration will be saved in --header <file> and the implementation in
 
 int main(int argc, char** argv) {
   InitProgram(UsageMessage(), &argc, &argv, true);
-  QCHECK(!absl::GetFlag(FLAGS_proto).empty());
-  QCHECK(!absl::GetFlag(FLAGS_header).empty());
-  QCHECK(!absl::GetFlag(FLAGS_source).empty());
+  if (absl::GetFlag(FLAGS_persistent_worker)) {
+    ::proto_builder::oss::SourceFileDatabase::SetCacheParsedFiles(true);
+    // Responses go to stdout, so everything else must be logged to stderr.
+    const absl::StatusOr<int> protocol_fd =
+        ::proto_builder::oss::RedirectOutputToLog(STDOUT_FILENO, STDERR_FILENO);
+    QCHECK_OK(protocol_fd.status());
+    QCHECK_OK(::proto_builder::oss::RunPersistentWorker(
+        STDIN_FILENO, *protocol_fd, &::proto_builder::HandleWorkRequest));
+    return 0;
+  }
+  QCHECK_OK(::proto_builder::CheckRequiredFlags());
   if (!absl::GetFlag(FLAGS_workdir).empty()) {
     QCHECK(file::oss::IsAbsolutePath(absl::GetFlag(FLAGS_workdir)));
     QCHECK_EQ(::chdir(absl::GetFlag(FLAGS_workdir).c_str()), 0);
   }
-  QCHECK_OK(::proto_builder::WriteProtoBuilderFiles());
+  QCHECK_OK(::proto_builder::RunProtoBuilder());
   return 0;
 }
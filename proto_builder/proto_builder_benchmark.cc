@@ -0,0 +1,582 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+// Benchmarks for the individual stages of the generator pipeline. All schemas
+// are synthesized in-process, so the numbers do not depend on the test protos:
+//
+// . wide:      A single message with `size` fields of all kinds.
+// . deep:      Messages nested `size` levels deep (sub-field setters).
+// . maps:      A single message with `size` map fields.
+// . annotated: A single message with `size` fields that carry
+//              FieldBuilderOptions (conversions, FOREACH_ADD, ...).
+//
+// Throughput is reported as fields/s (fields of the schema) and bytes/s (bytes
+// of generated code, or bytes written for `WriteFile`).
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "proto_builder/builder_writer.h"
+#include "proto_builder/descriptor_graph.h"
+#include "proto_builder/descriptor_util.h"
+#include "proto_builder/field_builder.h"
+#include "proto_builder/message_builder.h"
+#include "proto_builder/oss/file.h"
+#include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/wire_writer.h"
+#include "proto_builder/proto_builder.pb.h"
+#include "proto_builder/proto_builder_config.h"
+#include "proto_builder/proto_builder_data.h"
+#include "proto_builder/template_builder.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "absl/strings/str_cat.h"
+
+namespace proto_builder {
+
+using ::google::protobuf::DescriptorPool;
+using ::google::protobuf::DescriptorProto;
+using ::google::protobuf::FieldDescriptorProto;
+using ::google::protobuf::FileDescriptor;
+using ::google::protobuf::FileDescriptorProto;
+using ::google::protobuf::FileDescriptorSet;
+
+namespace {
+
+constexpr char kPackage[] = "proto_builder.benchmark";
+
+enum class Schema { kWide, kDeep, kMaps, kAnnotated };
+
+std::string SchemaName(Schema schema) {
+  switch (schema) {
+    case Schema::kWide:
+      return "wide";
+    case Schema::kDeep:
+      return "deep";
+    case Schema::kMaps:
+      return "maps";
+    case Schema::kAnnotated:
+      return "annotated";
+  }
+  return "unknown";
+}
+
+std::string TypeName(absl::string_view name) {
+  return absl::StrCat(".", kPackage, ".", name);
+}
+
+FieldDescriptorProto* AddField(
+    DescriptorProto* message, absl::string_view name,
+    FieldDescriptorProto::Type type, absl::string_view type_name = "",
+    FieldDescriptorProto::Label label = FieldDescriptorProto::LABEL_OPTIONAL) {
+  FieldDescriptorProto* field = message->add_field();
+  field->set_name(std::string(name));
+  field->set_number(message->field_size());
+  field->set_type(type);
+  field->set_label(label);
+  if (!type_name.empty()) {
+    field->set_type_name(std::string(type_name));
+  }
+  return field;
+}
+
+// Adds a field of the `index`-th kind (modulo the number of kinds).
+void AddFieldOfKind(DescriptorProto* message, absl::string_view prefix,
+                    int index) {
+  const std::string name = absl::StrCat(prefix, index);
+  switch (index % 9) {
+    case 0:
+      AddField(message, name, FieldDescriptorProto::TYPE_INT32);
+      break;
+    case 1:
+      AddField(message, name, FieldDescriptorProto::TYPE_INT64);
+      break;
+    case 2:
+      AddField(message, name, FieldDescriptorProto::TYPE_STRING);
+      break;
+    case 3:
+      AddField(message, name, FieldDescriptorProto::TYPE_DOUBLE);
+      break;
+    case 4:
+      AddField(message, name, FieldDescriptorProto::TYPE_BOOL);
+      break;
+    case 5:
+      AddField(message, name, FieldDescriptorProto::TYPE_ENUM,
+               TypeName("Kind"));
+      break;
+    case 6:
+      AddField(message, name, FieldDescriptorProto::TYPE_INT32, "",
+               FieldDescriptorProto::LABEL_REPEATED);
+      break;
+    case 7:
+      AddField(message, name, FieldDescriptorProto::TYPE_STRING, "",
+               FieldDescriptorProto::LABEL_REPEATED);
+      break;
+    case 8:
+      AddField(message, name, FieldDescriptorProto::TYPE_MESSAGE,
+               TypeName("Sub"));
+      break;
+  }
+}
+
+void AddMapField(DescriptorProto* message, int index) {
+  static const FieldDescriptorProto::Type kKeys[] = {
+      FieldDescriptorProto::TYPE_STRING,
+      FieldDescriptorProto::TYPE_INT32,
+      FieldDescriptorProto::TYPE_INT64,
+  };
+  static const std::pair<FieldDescriptorProto::Type, const char*> kValues[] = {
+      {FieldDescriptorProto::TYPE_INT32, ""},
+      {FieldDescriptorProto::TYPE_STRING, ""},
+      {FieldDescriptorProto::TYPE_MESSAGE, "Sub"},
+  };
+  const std::string entry_name = absl::StrCat("MapField", index, "Entry");
+  DescriptorProto* entry = message->add_nested_type();
+  entry->set_name(entry_name);
+  entry->mutable_options()->set_map_entry(true);
+  const auto& value = kValues[(index / 3) % 3];
+  AddField(entry, "key", kKeys[index % 3]);
+  AddField(entry, "value", value.first,
+           *value.second ? TypeName(value.second) : "");
+  AddField(message, absl::StrCat("map_field_", index),
+           FieldDescriptorProto::TYPE_MESSAGE,
+           TypeName(absl::StrCat("Root.", entry_name)),
+           FieldDescriptorProto::LABEL_REPEATED);
+}
+
+void AddAnnotatedField(DescriptorProto* message, int index) {
+  auto add_options = [](FieldDescriptorProto* field) {
+    return field->mutable_options()->AddExtension(::proto_builder::field);
+  };
+  switch (index % 5) {
+    case 0:
+      add_options(AddField(message, absl::StrCat("seconds_", index),
+                           FieldDescriptorProto::TYPE_INT64))
+          ->set_type("@ToInt64Seconds");
+      break;
+    case 1:
+      add_options(AddField(message, absl::StrCat("millis_", index),
+                           FieldDescriptorProto::TYPE_DOUBLE))
+          ->set_type("@ToDoubleMilliseconds");
+      break;
+    case 2: {
+      FieldDescriptorProto* field =
+          AddField(message, absl::StrCat("lines_", index),
+                   FieldDescriptorProto::TYPE_STRING, "",
+                   FieldDescriptorProto::LABEL_REPEATED);
+      add_options(field)->set_output(FieldBuilderOptions::BOTH);
+      for (auto output : {FieldBuilderOptions::FOREACH_ADD,
+                          FieldBuilderOptions::INITIALIZER_LIST}) {
+        FieldBuilderOptions* options = add_options(field);
+        options->set_output(output);
+        options->set_name(absl::StrCat("Lines", index));
+      }
+      break;
+    }
+    case 3: {
+      FieldDescriptorProto* field =
+          AddField(message, absl::StrCat("sub_", index),
+                   FieldDescriptorProto::TYPE_MESSAGE, TypeName("Sub"));
+      add_options(field)->set_output(FieldBuilderOptions::BOTH);
+      add_options(field)->set_type("@TextProto");
+      break;
+    }
+    case 4:
+      add_options(AddField(message, absl::StrCat("text_", index),
+                           FieldDescriptorProto::TYPE_STRING))
+          ->set_name(absl::StrCat("Alias", index));
+      break;
+  }
+}
+
+// A synthetic schema in its own pool. The pool falls back to the generated
+// pool, so that annotated schemas can import the proto_builder options.
+class SyntheticSchema {
+ public:
+  SyntheticSchema(Schema schema, int size)
+      : pool_(DescriptorPool::generated_pool()) {
+    FileDescriptorProto proto;
+    proto.set_name(absl::StrCat("proto_builder/benchmark/", SchemaName(schema),
+                                "_", size, ".proto"));
+    proto.set_package(kPackage);
+    if (schema == Schema::kAnnotated) {
+      proto.add_dependency("proto_builder/proto_builder.proto");
+    }
+    auto* kind = proto.add_enum_type();
+    kind->set_name("Kind");
+    for (const char* name : {"KIND_UNKNOWN", "KIND_A", "KIND_B"}) {
+      auto* value = kind->add_value();
+      value->set_name(name);
+      value->set_number(kind->value_size() - 1);
+    }
+    DescriptorProto* sub = proto.add_message_type();
+    sub->set_name("Sub");
+    AddField(sub, "value", FieldDescriptorProto::TYPE_INT32);
+    AddField(sub, "name", FieldDescriptorProto::TYPE_STRING);
+    DescriptorProto* root = proto.add_message_type();
+    root->set_name("Root");
+    switch (schema) {
+      case Schema::kWide:
+        for (int i = 0; i < size; ++i) {
+          AddFieldOfKind(root, "field_", i);
+        }
+        break;
+      case Schema::kDeep:
+        for (int level = 0; level <= size; ++level) {
+          DescriptorProto* message = level ? proto.add_message_type() : root;
+          if (level) {
+            message->set_name(absl::StrCat("Level", level));
+          }
+          for (int i = 0; i < 8; ++i) {
+            AddFieldOfKind(message, "field_", i);
+          }
+          if (level < size) {
+            AddField(message, "child", FieldDescriptorProto::TYPE_MESSAGE,
+                     TypeName(absl::StrCat("Level", level + 1)));
+          }
+        }
+        break;
+      case Schema::kMaps:
+        for (int i = 0; i < size; ++i) {
+          AddMapField(root, i);
+        }
+        break;
+      case Schema::kAnnotated:
+        for (int i = 0; i < size; ++i) {
+          AddAnnotatedField(root, i);
+        }
+        break;
+    }
+    file_ = PBCC_DIE_IF_NULL(pool_.BuildFile(proto));
+    for (int i = 0; i < file_->message_type_count(); ++i) {
+      num_fields_ += file_->message_type(i)->field_count();
+    }
+  }
+
+  const FileDescriptor& file() const { return *file_; }
+  const ::google::protobuf::Descriptor& root() const {
+    return *PBCC_DIE_IF_NULL(file_->FindMessageTypeByName("Root"));
+  }
+  int num_fields() const { return num_fields_; }
+
+  // The schema written to disk, once as .proto sources and once as a
+  // descriptor set, each including all transitive imports.
+  struct Files {
+    std::string proto_path;
+    std::string proto_file;
+    std::string descriptor_set;
+  };
+
+  const Files& GetFiles() {
+    if (files_.proto_file.empty()) {
+      const std::filesystem::path dir =
+          std::filesystem::temp_directory_path() / "proto_builder_benchmark" /
+          std::filesystem::path(file_->name()).stem();
+      FileDescriptorSet file_set;
+      WriteFiles(dir, *file_, &file_set);
+      files_.proto_path = dir.string();
+      files_.proto_file = (dir / file_->name()).string();
+      files_.descriptor_set = (dir / "descriptor_set.bin").string();
+      CHECK_OK(file::oss::SetContents(files_.descriptor_set,
+                                      file_set.SerializeAsString()));
+    }
+    return files_;
+  }
+
+ private:
+  static void WriteFiles(const std::filesystem::path& dir,
+                         const FileDescriptor& file,
+                         FileDescriptorSet* file_set) {
+    for (const auto& written : file_set->file()) {
+      if (written.name() == file.name()) {
+        return;
+      }
+    }
+    for (int i = 0; i < file.dependency_count(); ++i) {
+      WriteFiles(dir, *file.dependency(i), file_set);
+    }
+    file.CopyTo(file_set->add_file());
+    const std::filesystem::path path = dir / file.name();
+    std::filesystem::create_directories(path.parent_path());
+    CHECK_OK(file::oss::SetContents(path.string(), file.DebugString()));
+  }
+
+  DescriptorPool pool_;
+  const FileDescriptor* file_ = nullptr;
+  int num_fields_ = 0;
+  Files files_;
+};
+
+SyntheticSchema& GetSchema(Schema schema, int size) {
+  static auto& schemas =
+      *new std::map<std::pair<Schema, int>, std::unique_ptr<SyntheticSchema>>;
+  auto& result = schemas[{schema, size}];
+  if (!result) {
+    result = std::make_unique<SyntheticSchema>(schema, size);
+  }
+  return *result;
+}
+
+const ProtoBuilderConfigManager& GetConfig() {
+  static const auto& config = *new ProtoBuilderConfigManager();
+  return config;
+}
+
+size_t ContentSize(const BufferWriter& writer) {
+  size_t size = 0;
+  for (Where where : {HEADER, SOURCE, INTERFACE}) {
+    for (const std::string& line : writer.From(where)) {
+      size += line.size() + 1;
+    }
+  }
+  return size;
+}
+
+void SetCounters(benchmark::State& state, int fields, size_t bytes) {
+  state.counters["fields"] = benchmark::Counter(
+      static_cast<double>(fields) * state.iterations(),
+      benchmark::Counter::kIsRate);
+  if (bytes) {
+    state.SetBytesProcessed(static_cast<int64_t>(bytes) * state.iterations());
+  }
+}
+
+void BM_DescriptorUtilLoad(benchmark::State& state, Schema schema,
+                           bool descriptor_set) {
+  SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  const SyntheticSchema::Files& files = synthetic.GetFiles();
+  std::vector<std::string> descriptor_sets;
+  if (descriptor_set) {
+    descriptor_sets.push_back(files.descriptor_set);
+  }
+  const std::string proto_flag = absl::StrCat("*:", files.proto_file);
+  for (auto _ : state) {
+    auto descriptor_util = DescriptorUtil::Load(proto_flag, {},
+                                                {files.proto_path},
+                                                descriptor_sets);
+    CHECK_OK(descriptor_util.status());
+    benchmark::DoNotOptimize(descriptor_util->descriptors());
+  }
+  SetCounters(state, synthetic.num_fields(),
+              std::filesystem::file_size(descriptor_set ? files.descriptor_set
+                                                        : files.proto_file));
+}
+
+void BM_DescriptorUtilLoadSource(benchmark::State& state, Schema schema) {
+  BM_DescriptorUtilLoad(state, schema, /*descriptor_set=*/false);
+}
+
+void BM_DescriptorUtilLoadDescriptorSet(benchmark::State& state,
+                                        Schema schema) {
+  BM_DescriptorUtilLoad(state, schema, /*descriptor_set=*/true);
+}
+
+void BM_MessageBuilderWriteBuilder(benchmark::State& state, Schema schema) {
+  const SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  // Like TemplateBuilder, build the graph once and share it.
+  const DescriptorGraph graph({&synthetic.root()});
+  size_t bytes = 0;
+  for (auto _ : state) {
+    BufferWriter writer;
+    MessageBuilder({
+                       .config = GetConfig(),
+                       .writer = &writer,
+                       .descriptor = synthetic.root(),
+                       .max_field_depth = 99,
+                       .graph = &graph,
+                   })
+        .WriteBuilder();
+    bytes = ContentSize(writer);
+  }
+  SetCounters(state, synthetic.num_fields(), bytes);
+}
+
+void BM_FieldBuilderWriteField(benchmark::State& state, Schema schema) {
+  const SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  const ::google::protobuf::Descriptor& root = synthetic.root();
+  size_t bytes = 0;
+  for (auto _ : state) {
+    BufferWriter writer;
+    for (int i = 0; i < root.field_count(); ++i) {
+      const FieldDescriptor& field = *root.field(i);
+      const int size = std::max(1, field.options().ExtensionSize(
+                                       ::proto_builder::field));
+      for (int f = 0; f < size; ++f) {
+        FieldBuilder::WriteFieldForTesting({
+            .config = GetConfig(),
+            .writer = &writer,
+            .raw_field_options = GetConfig().MergeFieldBuilderOptions(
+                GetFieldBuilderOptionsOrDefault(field, f)),
+            .field = field,
+            .class_name = "RootBuilder",
+            .data_parent = "data_->",
+            .name_parent = "",
+            .first_method = !f,
+        });
+      }
+    }
+    bytes = ContentSize(writer);
+  }
+  SetCounters(state, root.field_count(), bytes);
+}
+
+// Keeps everything a TemplateBuilder references.
+struct TemplateBuilderInput {
+  explicit TemplateBuilderInput(const SyntheticSchema& synthetic)
+      : descriptors({&synthetic.root()}),
+        builder({
+            .config = GetConfig(),
+            .writer = &writer,
+            .descriptors = descriptors,
+            .header = header,
+            .tpl_head = DefaultHeaderTemplate(),
+            .tpl_body = DefaultSourceTemplate(),
+            .max_field_depth = 99,
+        }) {
+    CHECK_OK(builder.Prepare());
+  }
+
+  const std::vector<const ::google::protobuf::Descriptor*> descriptors;
+  const std::string header = "proto_builder/benchmark/root_builder.h";
+  BufferWriter writer;
+  TemplateBuilder builder;
+};
+
+void BM_TemplateBuilderFillDictionary(benchmark::State& state, Schema schema) {
+  const SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  TemplateBuilderInput input(synthetic);
+  for (auto _ : state) {
+    auto dict = input.builder.FillDictionary();
+    CHECK_OK(dict.status());
+    benchmark::DoNotOptimize(dict);
+  }
+  SetCounters(state, synthetic.num_fields(), /*bytes=*/0);
+}
+
+void BM_TemplateDictionaryExpand(benchmark::State& state, Schema schema) {
+  const SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  TemplateBuilderInput input(synthetic);
+  const auto dict = input.builder.FillDictionary();
+  CHECK_OK(dict.status());
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes = 0;
+    for (Where where : {HEADER, SOURCE}) {
+      const auto expanded = input.builder.ExpandTemplate(where, **dict);
+      CHECK_OK(expanded.status());
+      bytes += expanded->size();
+    }
+  }
+  SetCounters(state, synthetic.num_fields(), bytes);
+}
+
+template <class Writer>
+void BM_WriteFile(benchmark::State& state, Schema schema) {
+  const SyntheticSchema& synthetic = GetSchema(schema, state.range(0));
+  Writer writer;
+  MessageBuilder({
+                     .config = GetConfig(),
+                     .writer = &writer,
+                     .descriptor = synthetic.root(),
+                     .max_field_depth = 99,
+                 })
+      .WriteBuilder();
+  const std::string filename =
+      (std::filesystem::temp_directory_path() /
+       absl::StrCat("proto_builder_benchmark_", getpid(), ".cc"))
+          .string();
+  for (auto _ : state) {
+    CHECK_OK(writer.WriteFile(SOURCE, filename));
+  }
+  SetCounters(state, synthetic.num_fields(),
+              std::filesystem::file_size(filename));
+  std::filesystem::remove(filename);
+}
+
+void BM_BufferWriterWriteFile(benchmark::State& state, Schema schema) {
+  BM_WriteFile<BufferWriter>(state, schema);
+}
+
+void BM_ChunkedBufferWriterWriteFile(benchmark::State& state, Schema schema) {
+  BM_WriteFile<ChunkedBufferWriter>(state, schema);
+}
+
+// Writes 1000 values and then the next of `depth` levels of nested messages, so
+// that the lengths of all levels but the innermost need more than one byte.
+void WriteNestedMessages(oss::WireWriter* writer, int depth) {
+  for (int i = 0; i < 1000; ++i) {
+    writer->WriteInt32(1, i);
+  }
+  if (depth > 0) {
+    oss::WireWriter nested(writer, 2);
+    WriteNestedMessages(&nested, depth - 1);
+  }
+}
+
+void BM_WireWriterNestedMessages(benchmark::State& state) {
+  const int depth = state.range(0);
+  std::string output;
+  for (auto _ : state) {
+    output.clear();
+    oss::WireWriter writer(&output);
+    WriteNestedMessages(&writer, depth);
+  }
+  SetCounters(state, 1000 * (depth + 1), output.size());
+}
+
+BENCHMARK(BM_WireWriterNestedMessages)
+    ->RangeMultiplier(4)
+    ->Range(1, 256)
+    ->Unit(benchmark::kMicrosecond);
+
+// Registers `func` for all schemas with sizes that cover the extremes: the
+// 10k field message and nesting up to the max sub-field setter depth.
+#define PROTO_BUILDER_SCHEMA_BENCHMARK(func)                      \
+  BENCHMARK_CAPTURE(func, wide, Schema::kWide)                    \
+      ->Arg(100)                                                  \
+      ->Arg(10000)                                                \
+      ->Unit(benchmark::kMicrosecond);                            \
+  BENCHMARK_CAPTURE(func, deep, Schema::kDeep)                    \
+      ->DenseRange(1, MessageBuilder::kMaxSubFieldSetterDepth, 2) \
+      ->Unit(benchmark::kMicrosecond);                            \
+  BENCHMARK_CAPTURE(func, maps, Schema::kMaps)                    \
+      ->Arg(10)                                                   \
+      ->Arg(1000)                                                 \
+      ->Unit(benchmark::kMicrosecond);                            \
+  BENCHMARK_CAPTURE(func, annotated, Schema::kAnnotated)          \
+      ->Arg(100)                                                  \
+      ->Arg(1000)                                                 \
+      ->Unit(benchmark::kMicrosecond)
+
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_DescriptorUtilLoadSource);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_DescriptorUtilLoadDescriptorSet);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_MessageBuilderWriteBuilder);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_FieldBuilderWriteField);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_TemplateBuilderFillDictionary);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_TemplateDictionaryExpand);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_BufferWriterWriteFile);
+PROTO_BUILDER_SCHEMA_BENCHMARK(BM_ChunkedBufferWriterWriteFile);
+
+}  // namespace
+}  // namespace proto_builder
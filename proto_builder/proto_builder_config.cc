@@ -17,18 +17,21 @@
 #include "proto_builder/proto_builder_config.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 
 // Add logging for OSS.
 #include "proto_builder/oss/file.h"
 #include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/trace.h"
 #include "proto_builder/oss/util.h"
 #include "proto_builder/proto_builder.pb.h"
 #include "proto_builder/util.h"
 #include "google/protobuf/text_format.h"
 #include "absl/algorithm/container.h"
 #include "absl/flags/flag.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
@@ -38,6 +41,7 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "re2/re2.h"
 
 ABSL_FLAG(std::string, proto_builder_config, "",
@@ -52,21 +56,27 @@ static std::set<std::string> GetBuiltInTypeNames() {
   return {
       "string",
       "bytes",
+      "@BinaryProto",
       "@absl::string_view",
       "@Map:absl::string_view",
       "@TextProto",
       "@TextProto:absl::string_view",
       "@TextProto:Map:Value:absl::string_view",
+      "@TextProtoCached",
       "@ToInt64Seconds",
       "@ToInt64Milliseconds",
       "@ToDoubleSeconds",
       "@ToDoubleMilliseconds",
       "@ToProtoDuration",
       "@ToProtoTimestamp",
+      "%Arena",
+      "%CheckedPolicy",
       "%SourceLocation",
+      "%Span",
       "%Status",
       "%StatusOr",
       "%Validate",
+      "%WireWriter",
       "%LogSourceLocation",
   };
 }
@@ -122,14 +132,26 @@ bool VerifyTypeEntry(const std::string& key,
   return true;
 }
 
-ProtoBuilderConfig VerifyProtoBuilderConfig(absl::string_view textproto) {
+// Returns the content of the custom config file (--proto_builder_config), or
+// an empty string if none was specified.
+static std::string GetCustomConfigTextProto(
+    const std::string& custom_config_file) {
+  if (custom_config_file.empty()) {
+    return "";
+  }
+  auto [status, custom_config_textproto] =
+      UnpackStatusOrDefault(file::oss::GetContents(custom_config_file));
+  QCHECK(status.ok()) << "Custom config file error: " << status;
+  return custom_config_textproto;
+}
+
+static ProtoBuilderConfig VerifyProtoBuilderConfig(
+    absl::string_view textproto, const std::string& custom_config_file,
+    const std::string& custom_config_textproto) {
+  oss::TraceScope trace("VerifyProtoBuilderConfig");
   ProtoBuilderConfig config;
   QCHECK(google::protobuf::TextFormat::ParseFromString(std::string(textproto), &config));
-  std::string custom_config_file = absl::GetFlag(FLAGS_proto_builder_config);
   if (!custom_config_file.empty()) {
-    auto [status, custom_config_textproto] =
-        UnpackStatusOrDefault(file::oss::GetContents(custom_config_file));
-    QCHECK(status.ok()) << "Custom config file error: " << status;
     ProtoBuilderConfig custom_config;
     QCHECK(google::protobuf::TextFormat::ParseFromString(std::string(custom_config_textproto),
                                                &custom_config))
@@ -171,10 +193,31 @@ ProtoBuilderConfig VerifyProtoBuilderConfig(absl::string_view textproto) {
   return config;
 }
 
+ProtoBuilderConfig VerifyProtoBuilderConfig(absl::string_view textproto) {
+  const std::string custom_config_file =
+      absl::GetFlag(FLAGS_proto_builder_config);
+  return VerifyProtoBuilderConfig(textproto, custom_config_file,
+                                  GetCustomConfigTextProto(custom_config_file));
+}
+
 const ProtoBuilderConfig& GetGlobalProtoBuilderConfig() {
-  static const auto& kConfig =
-      *new ProtoBuilderConfig(VerifyProtoBuilderConfig(GetProtoTextConfig()));
-  return kConfig;
+  // A persistent worker handles requests with different custom configs, so
+  // the verified config is cached per custom config content.
+  static absl::Mutex mu(absl::kConstInit);
+  static auto& configs =
+      *new std::map<std::string, std::unique_ptr<const ProtoBuilderConfig>>();
+  const std::string custom_config_file =
+      absl::GetFlag(FLAGS_proto_builder_config);
+  const std::string custom_config_textproto =
+      GetCustomConfigTextProto(custom_config_file);
+  absl::MutexLock lock(&mu);
+  auto& config = configs[custom_config_textproto];
+  if (!config) {
+    config = absl::make_unique<const ProtoBuilderConfig>(
+        VerifyProtoBuilderConfig(GetProtoTextConfig(), custom_config_file,
+                                 custom_config_textproto));
+  }
+  return *config;
 }
 
 std::string NormalizeLabel(absl::string_view label) {
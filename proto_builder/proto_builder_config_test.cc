@@ -56,21 +56,27 @@ class ProtoBuilderConfigTest : public ::testing::Test {
     return {
         "string",
         "bytes",
+        "@BinaryProto",
         "@absl::string_view",
         "@Map:absl::string_view",
         "@TextProto",
         "@TextProto:absl::string_view",
         "@TextProto:Map:Value:absl::string_view",
+        "@TextProtoCached",
         "@ToInt64Seconds",
         "@ToInt64Milliseconds",
         "@ToDoubleSeconds",
         "@ToDoubleMilliseconds",
         "@ToProtoDuration",
         "@ToProtoTimestamp",
+        "%Arena",
+        "%CheckedPolicy",
         "%SourceLocation",
+        "%Span",
         "%Status",
         "%StatusOr",
         "%Validate",
+        "%WireWriter",
         "%LogSourceLocation",
     };
   }
@@ -169,14 +175,24 @@ TEST_F(ProtoBuilderConfigTest, GetBuiltinSpecialTypes) {
   EXPECT_THAT(
       config_manager_.GetSpecialTypes(),
       ElementsAre(
+          Pair("%Arena", Pointee(Partially(EqualsProto(
+                             R"pb(type: "::google::protobuf::Arena")pb")))),
+          Pair("%CheckedPolicy",
+               Pointee(Partially(EqualsProto(
+                   R"pb(type: "::proto_builder::oss::CheckedPolicy")pb")))),
           Key("%LogSourceLocation"),
           Pair("%SourceLocation", Pointee(Partially(EqualsProto(
                                       R"pb(type: "proto_builder::oss::SourceLocation")pb")))),
+          Pair("%Span",
+               Pointee(Partially(EqualsProto(R"pb(type: "absl::Span")pb")))),
           Pair("%Status",
                Pointee(Partially(EqualsProto(R"pb(type: "absl::Status")pb")))),
           Pair("%StatusOr", Pointee(Partially(
                                 EqualsProto(R"pb(type: "absl::StatusOr")pb")))),
-          Key("%Validate")));
+          Key("%Validate"),
+          Pair("%WireWriter",
+               Pointee(Partially(EqualsProto(
+                   R"pb(type: "::proto_builder::oss::WireWriter")pb"))))));
 }
 
 TEST_F(ProtoBuilderConfigTest, CamelCaseToSnakeCase) {
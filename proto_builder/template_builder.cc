@@ -19,12 +19,15 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "proto_builder/builder_writer.h"
 #include "proto_builder/oss/logging.h"
+#include "proto_builder/oss/thread_pool.h"
+#include "proto_builder/oss/trace.h"
 #include "proto_builder/oss/util.h"
 #include "proto_builder/proto_builder_config.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -78,6 +81,22 @@ bool UseValidator(const MessageBuilderOptions& options) {
   return options.use_validator();
 }
 
+bool UseArena(const MessageBuilderOptions& options) {
+  return options.use_arena();
+}
+
+bool UsePolicy(const MessageBuilderOptions& options) {
+  return options.use_policy();
+}
+
+bool UseView(const MessageBuilderOptions& options) {
+  return options.use_view();
+}
+
+bool UseWriter(const MessageBuilderOptions& options) {
+  return options.use_writer();
+}
+
 void AddIncludesForGlobalType(const std::string& type,
                               const ProtoBuilderConfigManager& config,
                               CodeInfoCollector& code_info) {
@@ -127,9 +146,11 @@ std::string InterfaceGuard(std::string in) {
 
 TemplateBuilder::MessageOutput::MessageOutput(
     const std::vector<std::string>& package_path, const ::google::protobuf::Descriptor& descriptor,
-    const Options& options)
+    const Options& options, const DescriptorGraph& graph)
     : config(options.config.Update(descriptor.options().GetExtension(message))),
       writer(package_path),
+      view_writer(package_path),
+      wire_writer(package_path),
       builder({
           .config = config,
           .writer = &writer,
@@ -137,6 +158,17 @@ TemplateBuilder::MessageOutput::MessageOutput(
           .max_field_depth = options.max_field_depth,
           .use_validator = options.use_validator,
           .make_interface = options.make_interface,
+          .inline_trivial_setters = options.inline_trivial_setters,
+          .graph = &graph,
+      }),
+      view_builder({
+          .config = config,
+          .writer = &view_writer,
+          .descriptor = descriptor,
+          .max_field_depth = options.max_field_depth,
+          .inline_trivial_setters = options.inline_trivial_setters,
+          .graph = &graph,
+          .make_view = true,
       }) {}
 
 TemplateBuilder::TemplateBuilder(Options options)
@@ -149,22 +181,81 @@ TemplateBuilder::TemplateBuilder(Options options)
           {SOURCE, options_.tpl_body},
       }),
       target_writer_(options_.writer),
-      message_outputs_(CreateMessageOutputs(package_path_, options_)) {}
+      own_graph_(options_.graph == nullptr
+                     ? std::make_unique<DescriptorGraph>(options_.descriptors)
+                     : nullptr),
+      graph_(own_graph_ ? *own_graph_ : *options_.graph),
+      message_outputs_(
+          CreateMessageOutputs(package_path_, options_, graph_)),
+      view_names_(CollectClassNames(message_outputs_, /*views=*/true)),
+      writer_names_(CollectClassNames(message_outputs_, /*views=*/false)) {}
 
-absl::Status TemplateBuilder::WriteBuilder() {
-  for (auto& message : message_outputs_) {
-    if (UseStatus(message->builder.root_options())) {
-      for (const auto& type :
-           {"%LogSourceLocation", "%SourceLocation", "%StatusOr", "%Status"}) {
-        AddIncludesForGlobalType(type, message->config,
-                                 *message->writer.CodeInfo());
-      }
+void TemplateBuilder::WriteMessageOutput(MessageOutput* message) const {
+  oss::TraceScope trace("WriteMessageOutput");
+  trace.AddArg("message", message->builder.root_descriptor().full_name());
+  // The default template moves the data in its rvalue constructors.
+  message->writer.CodeInfo()->AddInclude(HEADER, "<utility>");
+  if (UseStatus(message->builder.root_options())) {
+    for (const auto& type :
+         {"%LogSourceLocation", "%SourceLocation", "%StatusOr", "%Status"}) {
+      AddIncludesForGlobalType(type, message->config,
+                               *message->writer.CodeInfo());
+    }
+  }
+  if (UseArena(message->builder.root_options())) {
+    AddIncludesForGlobalType("%Arena", message->config,
+                             *message->writer.CodeInfo());
+  } else if (UseBuild(message->builder.root_options())) {
+    // For `Release()`.
+    message->writer.CodeInfo()->AddInclude(HEADER, "<memory>");
+  }
+  if (UsePolicy(message->builder.root_options())) {
+    AddIncludesForGlobalType("%CheckedPolicy", message->config,
+                             *message->writer.CodeInfo());
+  }
+  if (UseValidator(message->builder.root_options()) &&
+      !options_.validator_header.empty()) {
+    message->writer.CodeInfo()->AddInclude(HEADER, options_.validator_header);
+  }
+  message->builder.WriteBuilder(view_names_);
+  if (UsePolicy(message->builder.root_options())) {
+    // The class template is defined in the header, so that needs everything
+    // its methods use.
+    CodeInfoCollector& code_info = *message->writer.CodeInfo();
+    const std::set<std::string> source_includes = code_info.GetIncludes(SOURCE);
+    for (const std::string& include : source_includes) {
+      code_info.AddInclude(HEADER, include);
+    }
+  }
+  if (UseView(message->builder.root_options())) {
+    message->view_builder.WriteBuilder(view_names_);
+  }
+  if (UseWriter(message->builder.root_options())) {
+    AddIncludesForGlobalType("%WireWriter", message->config,
+                             *message->wire_writer.CodeInfo());
+    message->wire_writer.CodeInfo()->AddInclude(HEADER, "<string>");
+    message->builder.WriteWriter(&message->wire_writer, writer_names_);
+  }
+  trace.AddArg("header_lines", message->writer.Lines(HEADER).size());
+  trace.AddArg("source_lines", message->writer.Lines(SOURCE).size());
+  trace.AddArg("interface_lines", message->writer.Lines(INTERFACE).size());
+}
+
+absl::Status TemplateBuilder::Prepare() {
+  // Each message has its own config and writer, so messages can be generated
+  // independently. The results are combined in `message_outputs_` order by
+  // `FillDictionary`, which makes the output independent of `jobs`.
+  const size_t jobs = std::min(options_.jobs, message_outputs_.size());
+  if (jobs > 1) {
+    oss::ThreadPool pool(jobs);
+    for (auto& message : message_outputs_) {
+      pool.Schedule([this, &message] { WriteMessageOutput(message.get()); });
     }
-    if (UseValidator(message->builder.root_options()) &&
-        !options_.validator_header.empty()) {
-      message->writer.CodeInfo()->AddInclude(HEADER, options_.validator_header);
+    pool.Wait();
+  } else {
+    for (auto& message : message_outputs_) {
+      WriteMessageOutput(message.get());
     }
-    message->builder.WriteBuilder();
   }
   if (auto status = LoadTemplate(HEADER); !status.ok()) {
     return status;
@@ -177,6 +268,16 @@ absl::Status TemplateBuilder::WriteBuilder() {
       return status;
     }
   }
+  return absl::OkStatus();
+}
+
+absl::Status TemplateBuilder::WriteBuilder() {
+  oss::TraceScope trace("TemplateBuilder::WriteBuilder");
+  trace.AddArg("messages", message_outputs_.size());
+  trace.AddArg("jobs", options_.jobs);
+  if (auto status = Prepare(); !status.ok()) {
+    return status;
+  }
   const auto [dict_status, dict] = UnpackStatusOr(FillDictionary());
   if (!dict_status.ok()) {
     return dict_status;
@@ -207,8 +308,11 @@ void TemplateBuilder::FillIncludes(absl::string_view section_name,
   std::set<std::string> all_includes;
   for (const auto& message : message_outputs_) {
     for (auto where : wheres) {
-      const auto& includes = message->writer.CodeInfo()->GetIncludes(where);
-      all_includes.insert(includes.begin(), includes.end());
+      for (const auto* writer :
+           {&message->writer, &message->view_writer, &message->wire_writer}) {
+        const auto& includes = writer->CodeInfo()->GetIncludes(where);
+        all_includes.insert(includes.begin(), includes.end());
+      }
     }
   }
   if (options_.make_interface) {
@@ -246,6 +350,8 @@ void TemplateBuilder::FillDictionaryBasics(
   dict->SetValue("CLASS_NAME", message.builder.class_name());
   dict->SetValue("INTERFACE_NAME",
                  absl::StrCat(message.builder.class_name(), "Interface"));
+  dict->SetValue("VIEW_NAME", message.view_builder.class_name());
+  dict->SetValue("WRITER_NAME", message.builder.writer_name());
   std::string base_classes;
   if (!message.builder.root_options().base_class().empty()) {
     base_classes = absl::StrCat(
@@ -274,6 +380,9 @@ void TemplateBuilder::FillDictionaryBasics(
   dict->SetValue("VALIDATE_DATA", UseValidator(message.builder.root_options())
                                       ? absl::StrCat("ValidateData();")
                                       : "");
+  dict->SetValue("INVALIDATE_DATA", UseValidator(message.builder.root_options())
+                                        ? "data_validated_ = false;"
+                                        : "");
   for (const auto& [key, value] : message.config.GetExpandedTypes()) {
     dict->SetValue(key, value);
   }
@@ -293,6 +402,7 @@ void TemplateBuilder::MaybeAddSection(
 
 absl::StatusOr<std::unique_ptr<ctemplate::TemplateDictionary>>
 TemplateBuilder::FillDictionary() const {
+  oss::TraceScope trace("FillDictionary");
   std::unique_ptr<ctemplate::TemplateDictionary> dict(
       new ctemplate::TemplateDictionary("ProtoBuilder"));
   dict->SetValue("HEADER_GUARD", HeaderGuard(header_));
@@ -322,26 +432,75 @@ TemplateBuilder::FillDictionary() const {
   for (auto it = package_path_.crbegin(); it != package_path_.crend(); ++it) {
     dict->AddSectionDictionary("NAMESPACES_END")->SetValue("NAMESPACE", *it);
   }
+  if (!view_names_.empty() || !writer_names_.empty()) {
+    // Builders return views and writers return nested writers that may be
+    // defined later.
+    auto* declarations = dict->AddSectionDictionary("FORWARD_DECLARATIONS");
+    for (const auto& message : message_outputs_) {
+      if (UseView(message->builder.root_options())) {
+        declarations->AddSectionDictionary("FORWARD_DECLARATION")
+            ->SetValue("FORWARD_CLASS", message->view_builder.class_name());
+      }
+      if (UseWriter(message->builder.root_options())) {
+        declarations->AddSectionDictionary("FORWARD_DECLARATION")
+            ->SetValue("FORWARD_CLASS", message->builder.writer_name());
+      }
+    }
+  }
   for (const auto& message : message_outputs_) {
     auto* builder_dict = dict->AddSectionDictionary("BUILDER");
     FillDictionaryBasics(*message, builder_dict);
     builder_dict->SetValue("GENERATED_HEADER_CODE",
-                           absl::StrJoin(message->writer.From(HEADER), "\n"));
-    builder_dict->SetValue(
-        "GENERATED_INTERFACE_CODE",
-        absl::StrJoin(message->writer.From(INTERFACE), "\n"));
+                           message->writer.Contents(HEADER));
+    builder_dict->SetValue("GENERATED_INTERFACE_CODE",
+                           message->writer.Contents(INTERFACE));
     builder_dict->SetValue("GENERATED_SOURCE_CODE",
-                           absl::StrJoin(message->writer.From(SOURCE), "\n"));
-    MaybeAddSection(*message, "USE_BUILD", &UseBuild, builder_dict);
-    MaybeAddSection(*message, "USE_CONVERSION", &UseConversion, builder_dict);
-    MaybeAddSection(*message, "USE_STATUS", &UseStatus, builder_dict);
-    MaybeAddSection(*message, "USE_VALIDATOR", &UseValidator, builder_dict);
+                           message->writer.Contents(SOURCE));
+    if (UsePolicy(message->builder.root_options())) {
+      // All methods of the class template are in the header, so the feature
+      // sections only exist within USE_POLICY.
+      auto* policy_dict = builder_dict->AddSectionDictionary("USE_POLICY");
+      FillDictionaryBasics(*message, policy_dict);
+      MaybeAddSection(*message, "USE_CONVERSION", &UseConversion, policy_dict);
+      MaybeAddSection(*message, "USE_VALIDATOR", &UseValidator, policy_dict);
+    } else {
+      // Nested sections are only found in the section itself, so NOT_POLICY
+      // needs its own copies.
+      auto* not_policy_dict = builder_dict->AddSectionDictionary("NOT_POLICY");
+      FillDictionaryBasics(*message, not_policy_dict);
+      for (auto* section_dict : {builder_dict, not_policy_dict}) {
+        MaybeAddSection(*message, "USE_BUILD", &UseBuild, section_dict);
+        MaybeAddSection(*message, "USE_CONVERSION", &UseConversion,
+                        section_dict);
+        MaybeAddSection(*message, "USE_STATUS", &UseStatus, section_dict);
+        MaybeAddSection(*message, "USE_VALIDATOR", &UseValidator, section_dict);
+        MaybeAddSection(*message, "USE_ARENA", &UseArena, section_dict);
+      }
+    }
+    if (UseView(message->builder.root_options())) {
+      auto* view_dict = builder_dict->AddSectionDictionary("USE_VIEW");
+      FillDictionaryBasics(*message, view_dict);
+      view_dict->SetValue("GENERATED_VIEW_HEADER_CODE",
+                          message->view_writer.Contents(HEADER));
+      view_dict->SetValue("GENERATED_VIEW_SOURCE_CODE",
+                          message->view_writer.Contents(SOURCE));
+    }
+    if (UseWriter(message->builder.root_options())) {
+      auto* writer_dict = builder_dict->AddSectionDictionary("USE_WRITER");
+      FillDictionaryBasics(*message, writer_dict);
+      writer_dict->SetValue("GENERATED_WRITER_HEADER_CODE",
+                            message->wire_writer.Contents(HEADER));
+      writer_dict->SetValue("GENERATED_WRITER_SOURCE_CODE",
+                            message->wire_writer.Contents(SOURCE));
+    }
   }
   return std::move(dict);
 }
 
 absl::StatusOr<std::string> TemplateBuilder::ExpandTemplate(
     Where where, const ctemplate::TemplateDictionary& dict) const {
+  oss::TraceScope trace("ExpandTemplate");
+  trace.AddArg("where", Where_Name(where));
   std::string output;
   if (!ctemplate::ExpandTemplate(tpl_.at(where), ctemplate::DO_NOT_STRIP, &dict,
                                  &output)) {
@@ -358,6 +517,10 @@ static const std::pair<const RE2*, absl::string_view> kReplacements[] = {
     {new RE2("^\\s*//\\s*({{GENERATED_HEADER_CODE}}).*$"), "\\1"},
     {new RE2("^\\s*//\\s*({{GENERATED_INTERFACE_CODE}}).*$"), "\\1"},
     {new RE2("^\\s*//\\s*({{GENERATED_SOURCE_CODE}}).*$"), "\\1"},
+    {new RE2("^\\s*//\\s*({{GENERATED_VIEW_HEADER_CODE}}).*$"), "\\1"},
+    {new RE2("^\\s*//\\s*({{GENERATED_VIEW_SOURCE_CODE}}).*$"), "\\1"},
+    {new RE2("^\\s*//\\s*({{GENERATED_WRITER_HEADER_CODE}}).*$"), "\\1"},
+    {new RE2("^\\s*//\\s*({{GENERATED_WRITER_SOURCE_CODE}}).*$"), "\\1"},
     {new RE2("^(\\s*#\\s*(?:ifndef\\s|define\\s|endif\\s+//\\s?))"
              ".*({{HEADER_GUARD}}).*$"),
      "\\1\\2"},
@@ -392,14 +555,33 @@ void TemplateBuilder::Write(Where to, absl::string_view line) {
 // static
 std::vector<std::unique_ptr<TemplateBuilder::MessageOutput>>
 TemplateBuilder::CreateMessageOutputs(
-    const std::vector<std::string>& package_path, const Options& options) {
+    const std::vector<std::string>& package_path, const Options& options,
+    const DescriptorGraph& graph) {
   std::vector<std::unique_ptr<MessageOutput>> outputs;
   outputs.reserve(options.descriptors.size());
   for (const ::google::protobuf::Descriptor* descriptor : options.descriptors) {
     outputs.emplace_back(absl::make_unique<MessageOutput>(
-        package_path, *PBCC_DIE_IF_NULL(descriptor), options));
+        package_path, *PBCC_DIE_IF_NULL(descriptor), options, graph));
   }
   return outputs;
 }
 
+// static
+ClassNames TemplateBuilder::CollectClassNames(
+    const std::vector<std::unique_ptr<MessageOutput>>& message_outputs,
+    bool views) {
+  ClassNames names;
+  for (const auto& message : message_outputs) {
+    const MessageBuilderOptions& options = message->builder.root_options();
+    if (views && UseView(options)) {
+      names.emplace(&message->builder.root_descriptor(),
+                    message->view_builder.class_name());
+    } else if (!views && UseWriter(options)) {
+      names.emplace(&message->builder.root_descriptor(),
+                    message->builder.writer_name());
+    }
+  }
+  return names;
+}
+
 }  // namespace proto_builder
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "proto_builder/builder_writer.h"
+#include "proto_builder/descriptor_graph.h"
 #include "proto_builder/message_builder.h"
 #include "proto_builder/oss/template_dictionary.h"
 #include "proto_builder/proto_builder_config.h"
@@ -46,7 +47,7 @@ class TemplateBuilder {
  public:
   struct Options {
     const ProtoBuilderConfigManager& config;
-    BufferWriter* writer;
+    BuilderWriter* writer;
     const std::vector<const ::google::protobuf::Descriptor*>& descriptors;
     const std::string& header;
     const std::string& tpl_head;
@@ -55,28 +56,54 @@ class TemplateBuilder {
     const bool use_validator = false;
     const std::string validator_header = "";
     const bool make_interface = false;
+    // Default for the inline_trivial_setters message option.
+    const bool inline_trivial_setters = false;
     const std::string tpl_iface;
     const std::string interface_header;
+    // Number of threads used to generate the individual message builders.
+    // The output does not depend on this value.
+    const size_t jobs = 1;
+    // Graph containing all `descriptors`. If nullptr, then it gets built from
+    // `descriptors`.
+    const DescriptorGraph* graph = nullptr;
   };
 
   explicit TemplateBuilder(Options options);
 
+  // Runs `Prepare`, then expands the templates with the `FillDictionary`
+  // result and writes them.
   absl::Status WriteBuilder();
 
+  // The steps of `WriteBuilder`, so that benchmarks can time them separately.
+  // `Prepare` generates the code of all messages and loads the templates.
+  absl::Status Prepare();
+  absl::StatusOr<std::unique_ptr<ctemplate::TemplateDictionary>>
+  FillDictionary() const;
+  absl::StatusOr<std::string> ExpandTemplate(
+      Where where, const ctemplate::TemplateDictionary& dict) const;
+
  private:
   // A structure containing builders and writer for generating source for a
   // single message builder.
   struct MessageOutput {
     MessageOutput(const std::vector<std::string>& package_path,
-                  const ::google::protobuf::Descriptor& descriptor, const Options& options);
+                  const ::google::protobuf::Descriptor& descriptor, const Options& options,
+                  const DescriptorGraph& graph);
 
     const ProtoBuilderConfigManager config;
-    BufferWriter writer;
+    ChunkedBufferWriter writer;
+    // Code of the non-owning view, only used with `use_view`.
+    ChunkedBufferWriter view_writer;
+    // Code of the streaming writer, only used with `use_writer`.
+    ChunkedBufferWriter wire_writer;
     MessageBuilder builder;
+    MessageBuilder view_builder;
   };
 
-  absl::StatusOr<std::unique_ptr<ctemplate::TemplateDictionary>>
-  FillDictionary() const;
+  // Generates the code for a single message into its own writer. Only touches
+  // `message`, so this can run concurrently for different messages.
+  void WriteMessageOutput(MessageOutput* message) const;
+
   void MaybeAddSection(const MessageOutput& message, absl::string_view section,
                        std::function<bool(const MessageBuilderOptions&)> select,
                        ctemplate::TemplateDictionary* dict) const;
@@ -86,21 +113,29 @@ class TemplateBuilder {
                     bool strip_export,
                     const std::set<std::string>& drop_headers,
                     ctemplate::TemplateDictionary* dict) const;
-  absl::StatusOr<std::string> ExpandTemplate(
-      Where where, const ctemplate::TemplateDictionary& dict) const;
 
   absl::Status LoadTemplate(Where where);
   void Write(Where to, absl::string_view line);
 
   static std::vector<std::unique_ptr<MessageOutput>> CreateMessageOutputs(
-      const std::vector<std::string>& package_path, const Options& options);
+      const std::vector<std::string>& package_path, const Options& options,
+      const DescriptorGraph& graph);
+  // Returns the view (if `views`) or writer class names of all messages that
+  // enable them.
+  static ClassNames CollectClassNames(
+      const std::vector<std::unique_ptr<MessageOutput>>& message_outputs,
+      bool views);
 
   const Options options_;
   const std::vector<std::string> package_path_;
   const std::string header_;
   const std::map<Where, std::string> tpl_;
   NoDoubleEmptyLineWriter target_writer_;
+  const std::unique_ptr<const DescriptorGraph> own_graph_;
+  const DescriptorGraph& graph_;
   std::vector<std::unique_ptr<MessageOutput>> message_outputs_;
+  const ClassNames view_names_;
+  const ClassNames writer_names_;
 };
 
 }  // namespace proto_builder
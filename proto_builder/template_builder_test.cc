@@ -16,14 +16,55 @@
 
 #include "proto_builder/template_builder.h"
 
+#include <string>
+#include <vector>
+
+#include "proto_builder/builder_writer.h"
+#include "proto_builder/proto_builder_config.h"
+#include "proto_builder/tests/test_multiple_messages.pb.h"
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/strings/str_join.h"
 
 namespace proto_builder {
 namespace {
 
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
 class TemplateBuilderTest : public ::testing::Test {
  protected:
+  std::string WriteBuilder(size_t jobs) const {
+    const std::vector<const ::google::protobuf::Descriptor*> descriptors = {
+        TestMessageA::descriptor(),
+        TestMessageB::descriptor(),
+        TestMessageC::descriptor(),
+        TestMessageC::TestMessageD::descriptor(),
+    };
+    const std::string header = "proto_builder/tests/test_multiple_messages_builder.h";
+    const std::string tpl_head =
+        "{{#BUILDER}}// {{CLASS_NAME}}\n"
+        "{{GENERATED_HEADER_CODE}}\n{{/BUILDER}}";
+    const std::string tpl_body =
+        "{{#BUILDER}}// {{CLASS_NAME}}\n"
+        "{{GENERATED_SOURCE_CODE}}\n{{/BUILDER}}";
+    BufferWriter writer;
+    EXPECT_OK(TemplateBuilder({
+                                  .config = global_config_,
+                                  .writer = &writer,
+                                  .descriptors = descriptors,
+                                  .header = header,
+                                  .tpl_head = tpl_head,
+                                  .tpl_body = tpl_body,
+                                  .max_field_depth = 99,
+                                  .jobs = jobs,
+                              })
+                  .WriteBuilder());
+    return absl::StrJoin(writer.From(HEADER), "\n") + "\n" +
+           absl::StrJoin(writer.From(SOURCE), "\n");
+  }
+
+  const ProtoBuilderConfigManager global_config_;
 };
 
 TEST_F(TemplateBuilderTest, HeaderGuard) {
@@ -52,5 +93,13 @@ TEST_F(TemplateBuilderTest, StripPrefixDir) {
   EXPECT_THAT(StripPrefixDir("/mid/bla/", ""), "mid/bla/");
 }
 
+TEST_F(TemplateBuilderTest, ParallelOutputIsIdentical) {
+  const std::string serial = WriteBuilder(1);
+  EXPECT_THAT(serial, HasSubstr("// TestMessageC_TestMessageD"));
+  for (size_t jobs : {2, 4, 16}) {
+    EXPECT_THAT(WriteBuilder(jobs), Eq(serial)) << "jobs=" << jobs;
+  }
+}
+
 }  // namespace
 }  // namespace proto_builder
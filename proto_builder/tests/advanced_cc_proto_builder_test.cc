@@ -17,10 +17,12 @@
 #include "proto_builder/tests/advanced_cc_proto_builder.h"
 
 #include <ostream>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 #include "absl/status/status.h"
+#include "google/protobuf/arena.h"
 #include "proto_builder/oss/source_location.h"
 
 namespace absl {
@@ -43,6 +45,7 @@ std::ostream& operator<<(std::ostream& o,
 namespace proto_builder::tests {
 namespace {
 
+using ::testing::Pointee;
 using ::testing::oss::EqualsProto;
 using ::testing::status::oss::IsOk;
 using ::testing::status::oss::IsOkAndHolds;
@@ -65,6 +68,63 @@ TEST_F(AdvancedBuilderTest, ConsumeIsConsuming) {
   EXPECT_THAT(builder.Consume(), IsOkAndHolds(EqualsProto("")));
 }
 
+TEST_F(AdvancedBuilderTest, BuildFromRvalueMoves) {
+  auto builder = AdvancedBuilder().SetText("X");
+  EXPECT_THAT(std::move(builder).Build(),
+              IsOkAndHolds(EqualsProto(R"pb(text: "X")pb")));
+  auto failed = AdvancedBuilder().UpdateStatus(absl::UnknownError("error"));
+  EXPECT_THAT(std::move(failed).Build(), StatusIs(absl::StatusCode::kUnknown));
+}
+
+TEST_F(AdvancedBuilderTest, MaybeReleaseRawDataMoves) {
+  auto builder = AdvancedBuilder().SetText("X");
+  EXPECT_THAT(std::move(builder).MaybeReleaseRawData(),
+              IsOkAndHolds(EqualsProto(R"pb(text: "X")pb")));
+  auto failed = AdvancedBuilder().UpdateStatus(absl::UnknownError("error"));
+  EXPECT_THAT(std::move(failed).MaybeReleaseRawData(),
+              StatusIs(absl::StatusCode::kUnknown));
+}
+
+TEST_F(AdvancedBuilderTest, Release) {
+  auto builder = AdvancedBuilder().SetText("X");
+  EXPECT_THAT(builder.Release(),
+              IsOkAndHolds(Pointee(EqualsProto(R"pb(text: "X")pb"))));
+  EXPECT_THAT(builder, EqualsProto(""));
+  builder.UpdateStatus(absl::UnknownError("error"));
+  EXPECT_THAT(builder.Release(), StatusIs(absl::StatusCode::kUnknown));
+  EXPECT_THAT(builder.ok(), true);
+}
+
+TEST_F(AdvancedBuilderTest, Reset) {
+  AdvancedBuilder builder;
+  builder.SetText("X").UpdateStatus(absl::UnknownError("error"));
+  EXPECT_THAT(builder.ok(), false);
+  builder.Reset();
+  EXPECT_THAT(builder.status(), IsOk());
+  EXPECT_THAT(builder, EqualsProto(""));
+  EXPECT_THAT(builder.SetText("Y").Build(),
+              IsOkAndHolds(EqualsProto(R"pb(text: "Y")pb")));
+}
+
+TEST_F(AdvancedBuilderTest, BuildInto) {
+  Advanced out;
+  out.set_text("old");
+  auto builder = AdvancedBuilder().SetText("X");
+  EXPECT_THAT(builder.BuildInto(&out), IsOk());
+  EXPECT_THAT(out, EqualsProto(R"pb(text: "X")pb"));
+  EXPECT_THAT(builder, EqualsProto(""));
+  ::google::protobuf::Arena arena;
+  Advanced* arena_out =
+      ::google::protobuf::Arena::CreateMessage<Advanced>(&arena);
+  EXPECT_THAT(builder.SetText("Y").BuildInto(arena_out), IsOk());
+  EXPECT_THAT(*arena_out, EqualsProto(R"pb(text: "Y")pb"));
+  builder.SetText("Z").UpdateStatus(absl::UnknownError("error"));
+  EXPECT_THAT(builder.BuildInto(&out), StatusIs(absl::StatusCode::kUnknown));
+  EXPECT_THAT(out, EqualsProto(R"pb(text: "X")pb"));
+  EXPECT_THAT(builder.ok(), true);
+  EXPECT_THAT(builder, EqualsProto(""));
+}
+
 TEST_F(AdvancedBuilderTest, Error) {
   auto builder = AdvancedBuilder().SetText("X");
   EXPECT_THAT(builder.ok(), true);
@@ -0,0 +1,195 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/tests/arena_cc_proto_builder.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/status/status.h"
+#include "google/protobuf/arena.h"
+
+namespace proto_builder::tests {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Ne;
+using ::testing::Pointee;
+using ::testing::oss::EqualsProto;
+using ::testing::status::oss::IsOk;
+using ::testing::status::oss::IsOkAndHolds;
+using ::testing::status::oss::StatusIs;
+
+class ArenaBuilderTest : public ::testing::Test {
+ protected:
+  ::google::protobuf::Arena arena_;
+};
+
+TEST_F(ArenaBuilderTest, BuildReturnsArenaMessage) {
+  ArenaMessageBuilder builder(&arena_);
+  builder.SetName("foo").SetSubValue("bar").AddSubs(
+      ArenaMessage_SubBuilder().AddNumber(1));
+  EXPECT_EQ(builder.arena(), &arena_);
+  const auto result = builder.Build();
+  ASSERT_TRUE(result.ok());
+  EXPECT_THAT(*result, Pointee(EqualsProto(R"pb(
+                name: "foo"
+                sub { value: "bar" }
+                subs { number: 1 }
+              )pb")));
+  EXPECT_EQ((*result)->GetArena(), &arena_);
+  EXPECT_EQ((*result)->sub().GetArena(), &arena_);
+  EXPECT_EQ((*result)->subs(0).GetArena(), &arena_);
+  // Build does not copy, so the builder keeps handing out the same message.
+  EXPECT_THAT(builder.Build(), IsOkAndHolds(*result));
+}
+
+TEST_F(ArenaBuilderTest, ConsumeStartsOver) {
+  ArenaMessageBuilder builder(&arena_);
+  builder.InsertSubMap({"key", ArenaMessage_SubBuilder().SetValue("value")});
+  const auto first = builder.Consume();
+  ASSERT_TRUE(first.ok());
+  EXPECT_EQ((*first)->GetArena(), &arena_);
+  EXPECT_THAT(*first, Pointee(EqualsProto(R"pb(
+                sub_map {
+                  key: "key"
+                  value { value: "value" }
+                }
+              )pb")));
+  const auto second = builder.SetName("other").Consume();
+  ASSERT_TRUE(second.ok());
+  EXPECT_THAT(*second, Ne(*first));
+  EXPECT_THAT(*second, Pointee(EqualsProto(R"pb(name: "other")pb")));
+  EXPECT_THAT(*first, Pointee(EqualsProto(R"pb(
+                sub_map {
+                  key: "key"
+                  value { value: "value" }
+                }
+              )pb")));
+}
+
+TEST_F(ArenaBuilderTest, ConsumeError) {
+  ArenaMessageBuilder builder(&arena_);
+  builder.SetName("foo").UpdateStatus(absl::InternalError("error"));
+  EXPECT_THAT(builder.Consume(),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("error")));
+  EXPECT_THAT(builder.Consume(), IsOkAndHolds(Pointee(EqualsProto(""))));
+}
+
+TEST_F(ArenaBuilderTest, BuildInto) {
+  ArenaMessage* out =
+      ::google::protobuf::Arena::CreateMessage<ArenaMessage>(&arena_);
+  ArenaMessageBuilder builder(&arena_);
+  EXPECT_THAT(builder.SetName("foo").BuildInto(out), IsOk());
+  EXPECT_THAT(*out, EqualsProto(R"pb(name: "foo")pb"));
+  EXPECT_THAT(builder.Build(), IsOkAndHolds(Pointee(EqualsProto(""))));
+  ArenaMessage heap_out;
+  EXPECT_THAT(builder.SetName("bar").BuildInto(&heap_out), IsOk());
+  EXPECT_THAT(heap_out, EqualsProto(R"pb(name: "bar")pb"));
+}
+
+TEST_F(ArenaBuilderTest, Reset) {
+  ArenaMessageBuilder builder(&arena_);
+  builder.SetName("foo").UpdateStatus(absl::InternalError("error"));
+  const auto data = builder.Reset().Build();
+  ASSERT_TRUE(data.ok());
+  EXPECT_THAT(*data, Pointee(EqualsProto("")));
+  EXPECT_EQ((*data)->GetArena(), &arena_);
+}
+
+TEST_F(ArenaBuilderTest, InitialData) {
+  ArenaMessage data;
+  data.set_name("init");
+  ArenaMessageBuilder builder(&arena_, data);
+  EXPECT_THAT(builder.SetSubValue("x").Build(),
+              IsOkAndHolds(Pointee(EqualsProto(R"pb(
+                name: "init"
+                sub { value: "x" }
+              )pb"))));
+}
+
+TEST_F(ArenaBuilderTest, Conversion) {
+  ArenaOnlyBuilder builder(&arena_);
+  builder.SetName("foo").AddSubNumber(42);
+  const ArenaOnly& data = builder;
+  EXPECT_EQ(data.GetArena(), &arena_);
+  EXPECT_EQ(data.sub().GetArena(), &arena_);
+  EXPECT_THAT(data, EqualsProto(R"pb(
+                name: "foo"
+                sub { number: 42 }
+              )pb"));
+  ArenaOnlyBuilder moved(std::move(builder));
+  EXPECT_EQ(&static_cast<const ArenaOnly&>(moved), &data);
+}
+
+TEST_F(ArenaBuilderTest, MoveLeavesFreshMessage) {
+  ArenaMessageBuilder builder(&arena_);
+  builder.SetName("foo").UpdateStatus(absl::InternalError("error"));
+  ArenaMessageBuilder moved(std::move(builder));
+  EXPECT_EQ(builder.arena(), &arena_);  // NOLINT(bugprone-use-after-move)
+  EXPECT_THAT(builder.SetName("bar").Build(),
+              IsOkAndHolds(Pointee(EqualsProto(R"pb(name: "bar")pb"))));
+  EXPECT_THAT(moved.status(),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("error")));
+  EXPECT_THAT(moved.Reset().SetName("baz").Build(),
+              IsOkAndHolds(Pointee(EqualsProto(R"pb(name: "baz")pb"))));
+  EXPECT_THAT(builder.Build(),
+              IsOkAndHolds(Pointee(EqualsProto(R"pb(name: "bar")pb"))));
+}
+
+TEST_F(ArenaBuilderTest, MoveConstructibleOnly) {
+  static_assert(std::is_move_constructible_v<ArenaMessageBuilder>);
+  static_assert(!std::is_move_assignable_v<ArenaMessageBuilder>);
+  static_assert(std::is_move_constructible_v<ArenaOnlyBuilder>);
+  static_assert(!std::is_move_assignable_v<ArenaOnlyBuilder>);
+}
+
+TEST_F(ArenaBuilderTest, MoveArenaOnly) {
+  ArenaOnlyBuilder builder(&arena_);
+  builder.SetName("foo");
+  ArenaOnlyBuilder moved(std::move(builder));
+  builder.SetName("bar");  // NOLINT(bugprone-use-after-move)
+  EXPECT_THAT(static_cast<const ArenaOnly&>(moved),
+              EqualsProto(R"pb(name: "foo")pb"));
+  EXPECT_THAT(static_cast<const ArenaOnly&>(builder),
+              EqualsProto(R"pb(name: "bar")pb"));
+  EXPECT_EQ(static_cast<const ArenaOnly&>(builder).GetArena(), &arena_);
+}
+
+TEST(ArenaBuilderWithoutArenaTest, OwnsData) {
+  ArenaMessageBuilder builder(nullptr);
+  builder.SetName("foo").SetSubValue("bar");
+  EXPECT_EQ(builder.arena(), nullptr);
+  EXPECT_THAT(builder.Build(), IsOkAndHolds(Pointee(EqualsProto(R"pb(
+                name: "foo"
+                sub { value: "bar" }
+              )pb"))));
+  ArenaMessageBuilder moved(std::move(builder));
+  auto consumed = moved.Consume();
+  ASSERT_TRUE(consumed.ok());
+  // Without an arena the consumed message belongs to the caller.
+  const std::unique_ptr<ArenaMessage> owned(*consumed);
+  EXPECT_THAT(*owned, EqualsProto(R"pb(
+                name: "foo"
+                sub { value: "bar" }
+              )pb"));
+}
+
+}  // namespace
+}  // namespace proto_builder::tests
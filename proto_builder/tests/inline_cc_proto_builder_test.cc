@@ -0,0 +1,77 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proto_builder/tests/inline_cc_proto_builder.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+
+namespace proto_builder::tests {
+namespace {
+
+using ::testing::oss::EqualsProto;
+using ::testing::status::oss::IsOk;
+using ::testing::status::oss::StatusIs;
+
+class InlineTest : public ::testing::Test {};
+
+TEST_F(InlineTest, TrivialSetters) {
+  const std::vector<int64_t> values = {2, 3};
+  InlineMessageBuilder builder;
+  builder.SetId(1).SetName("name").AddValues(1).AddValues(values);
+  builder.SetSubName("sub");
+  EXPECT_THAT(builder, EqualsProto<InlineMessage>(R"pb(
+                id: 1
+                name: "name"
+                values: [ 1, 2, 3 ]
+                sub { name: "sub" }
+              )pb"));
+}
+
+TEST_F(InlineTest, OutOfLineSetters) {
+  InlineMessageBuilder builder;
+  builder.SetSeconds(absl::Seconds(5)).SetNumber(30);
+  EXPECT_THAT(builder, EqualsProto<InlineMessage>("seconds: 5 number: 30"));
+  EXPECT_THAT(builder.SetNumber(10).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(InlineTest, SetFromBuilder) {
+  InlineMessageBuilder builder;
+  builder.SetSub(InlineSubBuilder().SetName("sub"));
+  EXPECT_THAT(builder.status(), IsOk());
+  EXPECT_THAT(builder, EqualsProto<InlineMessage>(R"pb(
+                sub { name: "sub" }
+              )pb"));
+}
+
+TEST_F(InlineTest, EmptyInitializerListLeavesParentAbsent) {
+  InlineMessageBuilder builder;
+  builder.AddSubTags(std::initializer_list<std::string>{});
+  EXPECT_FALSE(static_cast<const InlineMessage&>(builder).has_sub());
+  builder.AddSubTags({"a", "b"});
+  EXPECT_THAT(builder, EqualsProto<InlineMessage>(R"pb(
+                sub { tag: [ "a", "b" ] }
+              )pb"));
+}
+
+}  // namespace
+}  // namespace proto_builder::tests
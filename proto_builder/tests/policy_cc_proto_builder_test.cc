@@ -0,0 +1,100 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proto_builder/tests/policy_cc_proto_builder.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/builder_policy.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/status/status.h"
+
+namespace proto_builder::tests {
+namespace {
+
+using ::proto_builder::oss::UncheckedPolicy;
+using ::testing::oss::EqualsProto;
+using ::testing::status::oss::IsOk;
+using ::testing::status::oss::IsOkAndHolds;
+using ::testing::status::oss::StatusIs;
+
+using UncheckedPolicyMessageBuilder = PolicyMessageBuilderT<UncheckedPolicy>;
+
+class PolicyTest : public ::testing::Test {};
+
+TEST_F(PolicyTest, CheckedIsDefault) {
+  PolicyMessageBuilder builder;
+  EXPECT_THAT(builder.SetNumber(30), EqualsProto<PolicyMessage>("number: 30"));
+  EXPECT_THAT(builder.status(), IsOk());
+  EXPECT_THAT(builder.SetNumber(10), EqualsProto<PolicyMessage>(""));
+  EXPECT_THAT(builder.status(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(builder.Build(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(builder.UpdateStatus(absl::OkStatus()).status(), IsOk());
+  EXPECT_THAT(builder, EqualsProto<PolicyMessage>("number: 30"));
+}
+
+TEST_F(PolicyTest, UncheckedDropsErrors) {
+  UncheckedPolicyMessageBuilder builder;
+  // The predicate still decides whether the field is set.
+  EXPECT_THAT(builder.SetNumber(10), EqualsProto<PolicyMessage>(""));
+  EXPECT_TRUE(builder.ok());
+  EXPECT_THAT(builder.SetNumber(30), EqualsProto<PolicyMessage>("number: 30"));
+  // Without status tracking errors are dropped.
+  builder.UpdateStatus(absl::InternalError("ignored"));
+  EXPECT_THAT(builder.status(), IsOk());
+  EXPECT_THAT(builder.Build(), IsOkAndHolds(EqualsProto<PolicyMessage>(R"pb(
+                number: 30
+              )pb")));
+}
+
+TEST_F(PolicyTest, Setters) {
+  const std::vector<int64_t> values = {1, 2, 3};
+  UncheckedPolicyMessageBuilder builder;
+  builder.SetName("name").AddValues(values).AddValues(4);
+  EXPECT_THAT(std::move(builder).Build(),
+              IsOkAndHolds(EqualsProto<PolicyMessage>(R"pb(
+                name: "name"
+                values: [ 1, 2, 3, 4 ]
+              )pb")));
+}
+
+TEST_F(PolicyTest, SetFromBuilder) {
+  PolicyMessageBuilder builder;
+  builder.SetSub(PolicySubBuilder().SetName("checked"));
+  EXPECT_THAT(builder, EqualsProto<PolicyMessage>(R"pb(
+                sub { name: "checked" }
+              )pb"));
+  // Builders with different policies can be combined.
+  UncheckedPolicyMessageBuilder unchecked;
+  unchecked.SetSub(PolicySubBuilderT<UncheckedPolicy>().SetName("unchecked"));
+  EXPECT_THAT(unchecked, EqualsProto<PolicyMessage>(R"pb(
+                sub { name: "unchecked" }
+              )pb"));
+  builder.SetSub(PolicySubBuilder().UpdateStatus(absl::InternalError("bad")));
+  EXPECT_THAT(builder.status(), StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST_F(PolicyTest, ConsumeResets) {
+  PolicyMessageBuilder builder;
+  builder.SetName("name").SetNumber(10);
+  EXPECT_THAT(builder.Consume(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(builder.status(), IsOk());
+  EXPECT_THAT(builder, EqualsProto<PolicyMessage>(""));
+}
+
+}  // namespace
+}  // namespace proto_builder::tests
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "proto_builder/tests/test_conversions_sub_binary.h"
 #include "proto_builder/tests/test_conversions_sub_builder.h"
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
@@ -107,6 +108,23 @@ TEST_F(TestConversionsBuilderTest, OptionalSub_TextProto) {
 }
 #endif
 
+TEST_F(TestConversionsBuilderTest, OptionalSub_TextProtoCached) {
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(ConversionsBuilder().SetOptionalSubCached("one: 1 two: 2"),
+                EqualsProto("optional_sub { one: 1 two: 2 }"));
+  }
+  EXPECT_THAT(ConversionsBuilder().SetOptionalSubCached("one: 3"),
+              EqualsProto("optional_sub { one: 3 }"));
+}
+
+TEST_F(TestConversionsBuilderTest, OptionalSub_BinaryProto) {
+  EXPECT_THAT(ConversionsBuilder().SetOptionalSubBinary(kConversionsSubBinary),
+              EqualsProto("optional_sub { one: 1 two: 300 }"));
+  const Conversions_Sub sub = Conversions_SubBuilder().SetOne(5);
+  EXPECT_THAT(ConversionsBuilder().SetOptionalSubBinary(sub.SerializeAsString()),
+              EqualsProto("optional_sub { one: 5 }"));
+}
+
 TEST_F(TestConversionsBuilderTest, AddRepeatedSub1) {
   const Conversions_Sub s1 = Conversions_SubBuilder().SetOne(1).SetTwo(2);
   const Conversions_Sub s2 = Conversions_SubBuilder().SetOne(3).SetTwo(4);
@@ -16,6 +16,10 @@
 
 #include "proto_builder/tests/test_message_builder.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 
@@ -89,5 +93,35 @@ TEST(TestMessageBuilderTest, Everything) {
               )pb"));
 }
 
+TEST(TestMessageBuilderTest, MovesFromTemporaries) {
+  TestMessage::Sub sub;
+  sub.set_sub_one("sub");
+  std::string seven = "seven";
+  const TestMessage message = TestMessageBuilder()
+                                  .SetThree(std::move(sub))
+                                  .AddFour(TestMessage::Sub())
+                                  .SetSeven(std::move(seven))
+                                  .AddThreeSubTwo(std::string("3-2"))
+                                  .InsertNine({"nine", TestMessage::Sub()});
+  EXPECT_THAT(message, EqualsProto(R"pb(
+                three { sub_one: "sub" sub_two: "3-2" }
+                four {}
+                seven: "seven"
+                nine: {
+                  key: "nine"
+                  value {}
+                }
+              )pb"));
+}
+
+TEST(TestMessageBuilderTest, AddsSpans) {
+  const std::vector<int32_t> values = {2, 3, 4};
+  EXPECT_THAT(TestMessageBuilder().AddTwo(1).AddTwo(values).AddAnd({5, 6}),
+              EqualsProto(R"pb(
+                two: [ 1, 2, 3, 4 ]
+                and: [ 5, 6 ]
+              )pb"));
+}
+
 }  // namespace
 }  // namespace proto_builder
@@ -25,12 +25,27 @@
 
 namespace protobuf::contrib::validator {
 
+using proto_builder::tests::IncrementalValidator;
 using proto_builder::tests::Validator;
+using proto_builder::tests::ViewValidator;
+
+// Counts the full message validations, so tests can verify they are cached.
+inline int& ValidateCalls() {
+  static int calls = 0;
+  return calls;
+}
 
 inline bool IsValidAddress(const std::string& address) {
   return address.empty() || address == "8.8.8.8" || address == "8.8.4.4";
 }
 
+inline absl::Status ValidateAddress(const std::string& address) {
+  if (!IsValidAddress(address)) {
+    return absl::InvalidArgumentError("Bad address");
+  }
+  return absl::OkStatus();
+}
+
 inline absl::Status Validate(const Validator::Fallback& v) {
   if (!IsValidAddress(v.address())) {
     return absl::InvalidArgumentError("Bad fallback address");
@@ -39,6 +54,7 @@ inline absl::Status Validate(const Validator::Fallback& v) {
 }
 
 inline absl::Status Validate(const Validator& v) {
+  ++ValidateCalls();
   if (!IsValidAddress(v.address())) {
     return absl::InvalidArgumentError("Bad address");
   }
@@ -64,6 +80,28 @@ inline absl::Status Validate(const Validator& v) {
   return absl::OkStatus();
 }
 
+inline absl::Status Validate(const ViewValidator::Entry& v) {
+  return ValidateAddress(v.address());
+}
+
+inline absl::Status Validate(const ViewValidator& v) {
+  for (const auto& e : v.entries()) {
+    absl::Status s = Validate(e);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Validate(v.entry());
+}
+
+inline absl::Status Validate(const IncrementalValidator& v) {
+  ++ValidateCalls();
+  if (v.comment() == "invalid") {
+    return absl::InvalidArgumentError("Bad comment");
+  }
+  return ValidateAddress(v.address());
+}
+
 }  // namespace protobuf::contrib::validator
 
 #endif  // PROTO_BUILDER_TESTS_VALIDATOR_PROTO_VALIDATOR_H_
@@ -3,10 +3,12 @@
 #include "gmock/gmock.h"
 #include "proto_builder/oss/testing/cpp_pb_gunit.h"
 #include "absl/status/status.h"
+#include "proto_builder/tests/validator.proto.validator.h"
 
 namespace proto_builder::tests {
 namespace {
 
+using ::protobuf::contrib::validator::ValidateCalls;
 using ::testing::oss::EqualsProto;
 using ::testing::HasSubstr;
 using ::testing::status::oss::IsOkAndHolds;
@@ -103,5 +105,67 @@ TEST_F(ValidatorBuilderTest, TestConversion) {
                        HasSubstr("Bad options address")));
 }
 
+TEST_F(ValidatorBuilderTest, TestValidationIsCached) {
+  ValidatorBuilder builder;
+  builder.SetAddress("8.8.8.8");
+  const int calls = ValidateCalls();
+  ASSERT_TRUE(builder.ok());
+  EXPECT_THAT(builder.Build(), IsOkAndHolds(EqualsProto("address: '8.8.8.8'")));
+  EXPECT_EQ(ValidateCalls(), calls + 1);
+  // Every setter requires a new validation.
+  EXPECT_THAT(builder.SetAddress("foo").Build(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Bad address")));
+  EXPECT_EQ(ValidateCalls(), calls + 2);
+  // A failed validation is not cached, so resetting the status validates again.
+  EXPECT_THAT(builder.UpdateStatus(absl::OkStatus()).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Bad address")));
+  EXPECT_EQ(ValidateCalls(), calls + 3);
+}
+
+TEST_F(ValidatorBuilderTest, TestIncrementalValidation) {
+  EXPECT_THAT(IncrementalValidatorBuilder().SetAddress("foo").Build(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Bad address")));
+  IncrementalValidatorBuilder builder;
+  builder.SetAddress("8.8.8.8");
+  const int calls = ValidateCalls();
+  ASSERT_TRUE(builder.ok());
+  EXPECT_EQ(ValidateCalls(), calls + 1);
+  // Setters without a predicate are not validated again.
+  EXPECT_THAT(builder.SetComment("invalid").Build(),
+              IsOkAndHolds(EqualsProto(R"pb(
+                address: "8.8.8.8"
+                comment: "invalid"
+              )pb")));
+  EXPECT_EQ(ValidateCalls(), calls + 1);
+  // Handing out the data starts over with a full validation.
+  ASSERT_TRUE(builder.Consume().ok());
+  EXPECT_THAT(builder.SetComment("invalid").Build(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Bad comment")));
+  EXPECT_EQ(ValidateCalls(), calls + 2);
+}
+
+TEST_F(ValidatorBuilderTest, TestViewInvalidatesCachedValidation) {
+  ViewValidatorBuilder builder;
+  ASSERT_TRUE(builder.ok());
+  ViewValidator_EntryBuilderView view = builder.AddEntriesBuilder();
+  ASSERT_TRUE(builder.ok());
+  view.SetAddress("BAD");
+  EXPECT_THAT(builder.Build(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                        HasSubstr("Bad address")));
+}
+
+TEST_F(ValidatorBuilderTest, TestMutableViewInvalidatesCachedValidation) {
+  ViewValidatorBuilder builder;
+  ViewValidator_EntryBuilderView view = builder.MutableEntry();
+  ASSERT_TRUE(builder.ok());
+  view.SetAddress("BAD");
+  EXPECT_THAT(builder.Build(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                        HasSubstr("Bad address")));
+}
+
 }  // namespace
 }  // namespace proto_builder::tests
@@ -0,0 +1,148 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/tests/view_cc_proto_builder.h"
+
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+
+namespace proto_builder::tests {
+namespace {
+
+using ::testing::oss::EqualsProto;
+
+// A hand written builder that only provides the documented `MaybeGetRawData`.
+class LeafGetOnlyBuilder {
+ public:
+  explicit LeafGetOnlyBuilder(absl::StatusOr<ViewMessage::Leaf> data)
+      : data_(std::move(data)) {}
+
+  absl::StatusOr<ViewMessage::Leaf> MaybeGetRawData() const { return data_; }
+
+ private:
+  absl::StatusOr<ViewMessage::Leaf> data_;
+};
+
+TEST(ViewTest, AddBuilderFillsElementInPlace) {
+  ViewMessageBuilder builder;
+  builder.SetName("foo");
+  builder.AddSubsBuilder().SetNumber(1).AddNames("a").AddNames("b");
+  builder.AddSubsBuilder().SetNumber(2);
+  const ViewMessage& data = builder;
+  EXPECT_THAT(data, EqualsProto(R"pb(
+                name: "foo"
+                subs { number: 1 names: "a" names: "b" }
+                subs { number: 2 }
+              )pb"));
+}
+
+TEST(ViewTest, ViewPointsIntoParent) {
+  ViewMessageBuilder builder;
+  ViewMessage_SubBuilderView view = builder.AddSubsBuilder();
+  const ViewMessage& data = builder;
+  EXPECT_EQ(&static_cast<const ViewMessage::Sub&>(view), &data.subs(0));
+  view.SetNumber(3);
+  EXPECT_EQ(data.subs(0).number(), 3);
+}
+
+TEST(ViewTest, NestedViews) {
+  ViewMessageBuilder builder;
+  ViewMessage_SubBuilderView sub = builder.AddSubsBuilder();
+  sub.AddLeavesBuilder().SetValue("x");
+  sub.AddLeavesBuilder().SetValue("y");
+  ViewMessage_SubBuilder sub_builder;
+  sub_builder.AddLeavesBuilder().SetValue("z");
+  builder.AddSubs(sub_builder);
+  EXPECT_THAT(static_cast<const ViewMessage&>(builder), EqualsProto(R"pb(
+                subs { leaves { value: "x" } leaves { value: "y" } }
+                subs { leaves { value: "z" } }
+              )pb"));
+}
+
+TEST(ViewTest, BuilderSetterFallsBackToMaybeGetRawData) {
+  ViewMessage::Leaf leaf;
+  leaf.set_value("x");
+  ViewMessageBuilder builder;
+  builder.AddSubLeaves(LeafGetOnlyBuilder(leaf));
+  builder.SetSubLeaf(LeafGetOnlyBuilder(leaf));
+  EXPECT_TRUE(builder.ok());
+  EXPECT_THAT(static_cast<const ViewMessage&>(builder), EqualsProto(R"pb(
+                sub {
+                  leaves { value: "x" }
+                  leaf { value: "x" }
+                }
+              )pb"));
+  builder.SetSubLeaf(LeafGetOnlyBuilder(absl::InternalError("bad")));
+  EXPECT_FALSE(builder.ok());
+}
+
+TEST(ViewTest, InsertBuilderFillsMapValueInPlace) {
+  ViewMessageBuilder builder;
+  builder.InsertSubMapBuilder("one").SetNumber(1);
+  builder.InsertLeafMapBuilder(7).SetValue("seven");
+  // An existing value is updated rather than replaced.
+  builder.InsertSubMapBuilder("one").AddNames("a");
+  EXPECT_THAT(static_cast<const ViewMessage&>(builder), EqualsProto(R"pb(
+                sub_map {
+                  key: "one"
+                  value { number: 1 names: "a" }
+                }
+                leaf_map {
+                  key: 7
+                  value { value: "seven" }
+                }
+              )pb"));
+}
+
+TEST(ViewTest, MutableReturnsViewOfField) {
+  ViewMessageBuilder builder;
+  builder.MutableSub().SetNumber(1).AddNames("a").MutableLeaf().SetValue("x");
+  builder.MutableSubLeaf().SetValue("y");
+  builder.MutableOther().SetNumber(2);
+  const ViewMessage& data = builder;
+  EXPECT_EQ(&static_cast<const ViewMessage::Sub&>(builder.MutableSub()),
+            &data.sub());
+  EXPECT_THAT(data, EqualsProto(R"pb(
+                sub {
+                  number: 1
+                  names: "a"
+                  leaf { value: "y" }
+                }
+                other { number: 2 }
+              )pb"));
+}
+
+TEST(ViewTest, MutableOnBuilderOfNestedType) {
+  ViewMessage_SubBuilder builder;
+  builder.MutableLeaf().SetValue("x");
+  EXPECT_THAT(static_cast<const ViewMessage::Sub&>(builder),
+              EqualsProto(R"pb(leaf { value: "x" })pb"));
+}
+
+TEST(ViewTest, BuildKeepsInPlaceElements) {
+  ViewMessageBuilder builder;
+  builder.AddSubsBuilder().SetNumber(5);
+  const auto result = std::move(builder).Build();
+  ASSERT_TRUE(result.ok());
+  EXPECT_THAT(*result, EqualsProto(R"pb(subs { number: 5 })pb"));
+}
+
+}  // namespace
+}  // namespace proto_builder::tests
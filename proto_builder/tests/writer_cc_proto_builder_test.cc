@@ -0,0 +1,86 @@
+// Copyright 2021 The CPP Proto Builder Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// READ: https://google.github.io/cpp-proto-builder
+
+#include "proto_builder/tests/writer_cc_proto_builder.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "proto_builder/oss/testing/cpp_pb_gunit.h"
+#include "absl/time/time.h"
+
+namespace proto_builder::tests {
+namespace {
+
+using ::testing::oss::EqualsProto;
+
+TEST(WriterTest, MatchesSerializedBuilder) {
+  const WriterMessage expected = WriterMessageBuilder()
+                                     .SetName("foo")
+                                     .SetDelta(-5)
+                                     .SetId(42)
+                                     .SetRatio(0.5)
+                                     .SetEnabled(true)
+                                     .SetKind(WriterMessage::FIRST)
+                                     .SetSubNumber(1)
+                                     .AddSubs(WriterMessage_SubBuilder()
+                                                  .SetNumber(2)
+                                                  .AddNames("a"))
+                                     .AddValues(-1)
+                                     .AddValues(300)
+                                     .SetSeconds(absl::Minutes(1));
+  std::string output;
+  WriterMessageWriter writer(&output);
+  writer.SetName("foo")
+      .SetDelta(-5)
+      .SetId(42)
+      .SetRatio(0.5)
+      .SetEnabled(true)
+      .SetKind(WriterMessage::FIRST);
+  writer.SetSub().SetNumber(1);
+  writer.AddSubs().SetNumber(2).AddNames("a");
+  writer.AddValues(-1).AddValues(300).SetSeconds(absl::Minutes(1));
+  // Fields are written in field number order, so the bytes are identical.
+  EXPECT_EQ(output, expected.SerializeAsString());
+}
+
+TEST(WriterTest, NestedWriters) {
+  std::string output;
+  {
+    WriterParentWriter writer(&output);
+    writer.SetSub().SetNumber(3).AddNames(std::string(200, 'x'));
+    writer.SetOther(NoWriterBuilder().SetValue("other"));
+  }
+  WriterParent parsed;
+  ASSERT_TRUE(parsed.ParseFromString(output));
+  EXPECT_THAT(parsed, EqualsProto(R"pb(
+                sub { number: 3 names: ")pb" + std::string(200, 'x') +
+                                  R"pb(" }
+                other { value: "other" }
+              )pb"));
+}
+
+TEST(WriterTest, SetMessage) {
+  std::string output;
+  WriterMessageWriter(&output).SetSub(
+      WriterMessage_SubBuilder().SetNumber(7).AddNames("b"));
+  WriterMessage parsed;
+  ASSERT_TRUE(parsed.ParseFromString(output));
+  EXPECT_THAT(parsed, EqualsProto(R"pb(sub { number: 7 names: "b" })pb"));
+}
+
+}  // namespace
+}  // namespace proto_builder::tests
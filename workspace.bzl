@@ -33,6 +33,13 @@ def init_cpp_pb_external_repositories():
         urls = ["https://github.com/google/googletest/archive/aa533abfd4232b01f9e57041d70114d5a77e6de0.zip"],
     )
 
+    # Google Benchmark
+    http_archive(
+        name = "com_github_google_benchmark",
+        strip_prefix = "benchmark-1.5.5",
+        urls = ["https://github.com/google/benchmark/archive/refs/tags/v1.5.5.tar.gz"],
+    )
+
     # Abseil, March 2021 LTS commit.
     http_archive(
         name = "com_google_absl",